@@ -1,11 +1,20 @@
 #include "components.h"
 
-const Key VALID_KEYS[] = {KEY_A, KEY_B, KEY_C, KEY_D, KEY_E, KEY_F, KEY_G, KEY_H, KEY_I, KEY_J, KEY_K, KEY_L, KEY_M, KEY_N, KEY_O, KEY_P, KEY_Q, KEY_R, KEY_S, KEY_T, KEY_U, KEY_V, KEY_W, KEY_X, KEY_Y, KEY_Z, KEY_0, KEY_1, KEY_2, KEY_3, KEY_4, KEY_5, KEY_6, KEY_7, KEY_8, KEY_9, KEY_NUMPAD_0, KEY_NUMPAD_1, KEY_NUMPAD_2, KEY_NUMPAD_3, KEY_NUMPAD_4, KEY_NUMPAD_5, KEY_NUMPAD_6, KEY_NUMPAD_7, KEY_NUMPAD_8, KEY_NUMPAD_9, KEY_SPACE, KEY_BACKSPACE};
-const char VALID_CHARS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ01234567890123456789 ";
+void updateButtonState(Button *btn, bool over);
+bool typeCharacter(TextField *txt, Uint16 c);
+void growTextImage(TextField *txt, int width);
+void addWidget(UI *ui, Button *btn, TextField *txt, Rectangle bounds);
+SDL_Surface *newAlphaSurface(int width, int height);
+void copySurface(SDL_Surface *src, SDL_Rect *section, SDL_Surface *dst, int x, int y);
+SDL_Surface *optimizeSurface(SDL_Surface *surface);
+void buildButtonCache(Button *btn);
+void buildTextFieldCache(TextField *txt);
+void buildUIGrid(UI *ui);
+int findWidget(UI *ui, Point pos);
 
 Button *newButton(Point pos, Image *imgs, Font *font, char *text, Color color)
 {
-	Button *btn = (Button *)safeMalloc(sizeof(*btn));
+	Button *btn = (Button *)taggedMalloc(sizeof(*btn), MEMORY_COMPONENTS);
 	btn->obj = newBlockSprite(pos, imgs, 1, 3);
 	btn->text = text;
 	if (text) btn->textImg = getDrawnText(font, text, color);
@@ -13,42 +22,57 @@ Button *newButton(Point pos, Image *imgs, Font *font, char *text, Color color)
 	if (text)
 		btn->textPos = newPoint((getBounds(btn->obj).size.x - btn->textImg->w) / 2, (getBounds(btn->obj).size.y - btn->textImg->h) / 2);
 	btn->state = BUTTON_STATE_UP;
+	btn->cache = NULL;
+	btn->dirty = true;
 	return btn;
 }
 
 TextField *newTextField(Point pos, Image *box, Image *cursor, byte maxLength, Font *font, Color color)
 {
-	TextField *txt = (TextField *)safeMalloc(sizeof(*txt));
+	TextField *txt = (TextField *)taggedMalloc(sizeof(*txt), MEMORY_COMPONENTS);
 	txt->box = newBlock(pos, box);
 	Point curPos = newPoint(pos.x + 3, pos.y + 3);
 	txt->cursor = newBlock(curPos, cursor);
 	txt->font = font;
-	txt->text = (char *)safeMalloc((maxLength + 1) * sizeof(char));
+	txt->text = (char *)taggedMalloc((3 * maxLength + 1) * sizeof(char), MEMORY_TEXT);
 	txt->text[0] = 0;
 	txt->textImg = NULL;
 	txt->textColor = color;
 	txt->length = 0;
 	txt->maxLength = maxLength;
+	txt->textBytes = 0;
+	txt->glyphX = (short *)taggedMalloc((maxLength + 1) * sizeof(short), MEMORY_TEXT);
+	txt->glyphX[0] = 0;
+	txt->heldKey = SDLK_UNKNOWN;
+	txt->heldChar = 0;
 	txt->cursorTimer = 0;
 	txt->showCursor = true;
+	txt->cache = NULL;
+	txt->dirty = true;
 	return txt;
 }
 
 void updateButton(Button *btn)
 {
+	updateButtonState(btn, isMouseOver(getBounds(btn->obj)));
+}
+
+void updateButtonState(Button *btn, bool over)
+{
+	byte state = btn->state;
 	if (btn->state == BUTTON_STATE_CLICKED)
 		btn->state = BUTTON_STATE_UP;
 	
 	switch (btn->state)
 	{
 		case BUTTON_STATE_UP:
-			if (isMouseOver(getBounds(btn->obj)))
+			if (over)
 			{
 				btn->obj->imgIndex = 1;
 				btn->state = BUTTON_STATE_OVER;
 			} break;
 		case BUTTON_STATE_OVER:
-			if (!isMouseOver(getBounds(btn->obj)))
+			if (!over)
 			{
 				btn->obj->imgIndex = 0;
 				btn->state = BUTTON_STATE_UP;
@@ -59,7 +83,7 @@ void updateButton(Button *btn)
 				btn->state = BUTTON_STATE_DOWN;
 			} break;
 		case BUTTON_STATE_DOWN:
-			if (!isMouseOver(getBounds(btn->obj)))
+			if (!over)
 			{
 				btn->obj->imgIndex = 0;
 				btn->state = BUTTON_STATE_DOWN_OUT;
@@ -70,7 +94,7 @@ void updateButton(Button *btn)
 				btn->state = BUTTON_STATE_CLICKED;
 			} break;
 		case BUTTON_STATE_DOWN_OUT:
-			if (isMouseOver(getBounds(btn->obj)))
+			if (over)
 			{
 				btn->obj->imgIndex = 2;
 				btn->state = BUTTON_STATE_DOWN;
@@ -81,71 +105,66 @@ void updateButton(Button *btn)
 				btn->state = BUTTON_STATE_UP;
 			} break;
 	}
+	if (btn->state != state) btn->dirty = true;
 }
 
 void updateTextField(TextField *txt)
 {
 	int i;
 	bool changed = false;
-	for (i = 0; i < NUM_VALID_KEYS; i++)
+	for (i = 0; i < getInputEventCount(); i++)
 	{
-		if (isKeyPressed(VALID_KEYS[i]) || isKeyHeld(VALID_KEYS[i]))
-		{
-			if (i == NUM_VALID_KEYS - 1)
-			{
-				if (txt->length > 0)
-					txt->text[--(txt->length)] = 0;
-				changed = true;
-			}
-			else if (txt->length < txt->maxLength)
-			{
-				char digit[2];
-				digit[0] = VALID_CHARS[i];
-				digit[1] = 0;
-				strcat(txt->text, digit);
-				txt->length++;
-				changed = true;
-			}
-			break;
-		}
+		InputEvent *e = getInputEvent(i);
+		if (e->type != INPUT_KEY_DOWN) continue;
+		Uint16 c = e->key == KEY_BACKSPACE ? '\b' : e->unicode;
+		if (c != '\b' && (c < 32 || c == 127)) continue;
+		changed |= typeCharacter(txt, c);
+		txt->heldKey = e->key;
+		txt->heldChar = c;
+	}
+
+	// A repetição de tecla segurada é emulada com isKeyHeld, com a mesma cadência das demais teclas
+	if (txt->heldKey != SDLK_UNKNOWN)
+	{
+		if (!isKeyDown(txt->heldKey)) txt->heldKey = SDLK_UNKNOWN;
+		else if (isKeyHeld(txt->heldKey)) changed |= typeCharacter(txt, txt->heldChar);
 	}
+
 	if (changed)
 	{
-		if (txt->textImg) SDL_FreeSurface(txt->textImg);
-		if (txt->length > 0) txt->textImg = getDrawnText(txt->font, txt->text, txt->textColor);
-		else txt->textImg = NULL;
 		setPosition(txt->cursor, 
-			newPoint(getBounds(txt->box).position.x + (txt->textImg ? txt->textImg->w : 0) + 3, getBounds(txt->box).position.y + 3));
+			newPoint(getBounds(txt->box).position.x + txt->glyphX[txt->length] + 3, getBounds(txt->box).position.y + 3));
 		txt->showCursor = true;
 		txt->cursorTimer = 0;
+		txt->dirty = true;
 	}
 	txt->cursorTimer++;
 	if (txt->cursorTimer == CURSOR_BLINK_INTERVAL)
 	{
 		txt->showCursor = !(txt->showCursor);
 		txt->cursorTimer = 0;
+		txt->dirty = true;
 	}
 }
 
 void drawButton(Button *btn)
 {
-	drawObject(btn->obj);
-	if (btn->text)
-		drawSurface(btn->textImg, getBounds(btn->obj).position.x + btn->textPos.x, getBounds(btn->obj).position.y + btn->textPos.y);
+	if (btn->dirty) buildButtonCache(btn);
+	drawSurface(btn->cache, roundFloat(getBounds(btn->obj).position.x - btn->obj->boundsPos.x), roundFloat(getBounds(btn->obj).position.y - btn->obj->boundsPos.y));
 }
 
 void drawTextField(TextField *txt)
 {
-	drawObject(txt->box);
-	if (txt->textImg) drawSurface(txt->textImg, getBounds(txt->box).position.x + 3, getBounds(txt->box).position.y + 3);
-	if (txt->showCursor) drawObject(txt->cursor);
+	if (txt->dirty) buildTextFieldCache(txt);
+	drawSurface(txt->cache, roundFloat(getBounds(txt->box).position.x - txt->box->boundsPos.x), roundFloat(getBounds(txt->box).position.y - txt->box->boundsPos.y));
 }
 
 void freeButton(Button *btn)
 {
 	freeObject(btn->obj);
 	if (btn->text) SDL_FreeSurface(btn->textImg);
-	free(btn);
+	if (btn->cache) SDL_FreeSurface(btn->cache);
+	taggedFree(btn);
 }
 
 void freeTextField(TextField *txt)
@@ -153,8 +172,340 @@ void freeTextField(TextField *txt)
 	freeObject(txt->box);
 	freeObject(txt->cursor);
 	SDL_FreeSurface(txt->textImg);
+	if (txt->cache) SDL_FreeSurface(txt->cache);
 	TTF_CloseFont(txt->font);
-	free(txt->text);
-	free(txt);
+	taggedFree(txt->text);
+	taggedFree(txt->glyphX);
+	taggedFree(txt);
 }
 
+UI *newUI()
+{
+	UI *ui = (UI *)taggedMalloc(sizeof(*ui), MEMORY_COMPONENTS);
+	ui->widgets = NULL;
+	ui->size = ui->capacity = 0;
+	ui->gridOrigin = newPoint(0, 0);
+	ui->gridColumns = ui->gridLines = 0;
+	ui->cellStart = ui->cellWidgets = NULL;
+	ui->gridDirty = true;
+	ui->hovered = ui->pressed = -1;
+	ui->focus = NULL;
+	ui->lastMouse = newPoint(-1, -1);
+	return ui;
+}
+
+void addButtonToUI(UI *ui, Button *btn)
+{
+	addWidget(ui, btn, NULL, getBounds(btn->obj));
+}
+
+void addTextFieldToUI(UI *ui, TextField *txt)
+{
+	addWidget(ui, NULL, txt, getBounds(txt->box));
+	if (ui->focus == NULL) ui->focus = txt;
+	else txt->showCursor = false;
+}
+
+void updateUI(UI *ui)
+{
+	// O componente sob o mouse só é procurado quando o mouse se move ou a grade muda
+	Point mouse = getMousePosition();
+	int previous = ui->hovered;
+	if (ui->gridDirty || mouse.x != ui->lastMouse.x || mouse.y != ui->lastMouse.y)
+	{
+		if (ui->gridDirty) buildUIGrid(ui);
+		ui->hovered = findWidget(ui, mouse);
+		ui->lastMouse = mouse;
+	}
+
+	// Apenas o botão que deixou de estar sob o mouse, o botão sob o mouse e o botão pressionado mudam de estado
+	if (previous >= 0 && previous != ui->hovered && ui->widgets[previous].button)
+		updateButtonState(ui->widgets[previous].button, false);
+	if (ui->pressed >= 0 && ui->pressed != ui->hovered && ui->pressed != previous)
+		updateButtonState(ui->widgets[ui->pressed].button, false);
+	if (ui->hovered >= 0 && ui->widgets[ui->hovered].button)
+		updateButtonState(ui->widgets[ui->hovered].button, true);
+
+	if (ui->pressed >= 0)
+	{
+		byte state = ui->widgets[ui->pressed].button->state;
+		if (state != BUTTON_STATE_DOWN && state != BUTTON_STATE_DOWN_OUT) ui->pressed = -1;
+	}
+	if (ui->hovered >= 0 && ui->widgets[ui->hovered].button && ui->widgets[ui->hovered].button->state == BUTTON_STATE_DOWN)
+		ui->pressed = ui->hovered;
+
+	// Um clique num campo de texto move o foco para ele
+	if (ui->hovered >= 0 && ui->widgets[ui->hovered].field && isMousePressed(BUTTON_LEFT) && ui->widgets[ui->hovered].field != ui->focus)
+	{
+		if (ui->focus)
+		{
+			ui->focus->showCursor = false;
+			ui->focus->dirty = true;
+		}
+		ui->focus = ui->widgets[ui->hovered].field;
+		ui->focus->showCursor = true;
+		ui->focus->cursorTimer = 0;
+		ui->focus->dirty = true;
+	}
+	if (ui->focus) updateTextField(ui->focus);
+}
+
+void drawUI(UI *ui)
+{
+	int i;
+	for (i = 0; i < ui->size; i++)
+		if (ui->widgets[i].button) drawButton(ui->widgets[i].button);
+		else drawTextField(ui->widgets[i].field);
+}
+
+int drawChangedUI(UI *ui)
+{
+	int i, count = 0;
+	for (i = 0; i < ui->size; i++)
+	{
+		Widget *w = &ui->widgets[i];
+		if (w->button ? !w->button->dirty : !w->field->dirty) continue;
+		Object *obj = w->button ? w->button->obj : w->field->box;
+		if (w->button) drawButton(w->button);
+		else drawTextField(w->field);
+		SDL_Surface *cache = w->button ? w->button->cache : w->field->cache;
+		markScreenArea(newRectangle(roundFloat(w->bounds.position.x - obj->boundsPos.x), roundFloat(w->bounds.position.y - obj->boundsPos.y), cache->w, cache->h));
+		count++;
+	}
+	return count;
+}
+
+void freeUI(UI *ui)
+{
+	int i;
+	for (i = 0; i < ui->size; i++)
+		if (ui->widgets[i].button) freeButton(ui->widgets[i].button);
+		else freeTextField(ui->widgets[i].field);
+	taggedFree(ui->widgets);
+	taggedFree(ui->cellStart);
+	taggedFree(ui->cellWidgets);
+	taggedFree(ui);
+}
+
+bool typeCharacter(TextField *txt, Uint16 c)
+{
+	if (c == '\b')
+	{
+		if (txt->length == 0) return false;
+
+		// Recua até o primeiro byte do último caractere e apaga sua área da imagem
+		do txt->textBytes--;
+		while (txt->textBytes > 0 && (txt->text[txt->textBytes] & 0xC0) == 0x80);
+		txt->text[txt->textBytes] = 0;
+		txt->length--;
+		SDL_Rect r = {txt->glyphX[txt->length], 0, txt->textImg->w - txt->glyphX[txt->length], txt->textImg->h};
+		SDL_FillRect(txt->textImg, &r, 0);
+		return true;
+	}
+	if (txt->length >= txt->maxLength) return false;
+
+	char utf8[4];
+	if (c < 0x80)
+	{
+		utf8[0] = c;
+		utf8[1] = 0;
+	}
+	else if (c < 0x800)
+	{
+		utf8[0] = 0xC0 | (c >> 6);
+		utf8[1] = 0x80 | (c & 0x3F);
+		utf8[2] = 0;
+	}
+	else
+	{
+		utf8[0] = 0xE0 | (c >> 12);
+		utf8[1] = 0x80 | ((c >> 6) & 0x3F);
+		utf8[2] = 0x80 | (c & 0x3F);
+		utf8[3] = 0;
+	}
+
+	// Apenas o novo caractere é renderizado, e copiado para o fim do texto já desenhado
+	SDL_Surface *glyph = getDrawnText(txt->font, utf8, txt->textColor);
+	int advance = glyph->w, x = txt->glyphX[txt->length];
+	TTF_GlyphMetrics(txt->font, c, NULL, NULL, NULL, NULL, &advance);
+	growTextImage(txt, x + (glyph->w > advance ? glyph->w : advance));
+	SDL_SetAlpha(glyph, 0, SDL_ALPHA_OPAQUE);
+	SDL_Rect r = {x, 0, 0, 0};
+	SDL_BlitSurface(glyph, NULL, txt->textImg, &r);
+	SDL_FreeSurface(glyph);
+
+	strcpy(txt->text + txt->textBytes, utf8);
+	txt->textBytes += strlen(utf8);
+	txt->glyphX[++(txt->length)] = x + advance;
+	return true;
+}
+
+void growTextImage(TextField *txt, int width)
+{
+	if (txt->textImg && txt->textImg->w >= width) return;
+
+	// A largura dobra a cada crescimento, e a imagem começa com espaço para o comprimento máximo em caracteres da largura da fonte
+	int w = txt->textImg ? 2 * txt->textImg->w : txt->maxLength * TTF_FontHeight(txt->font) / 2;
+	if (w < width) w = width;
+	SDL_Surface *img = newAlphaSurface(w, TTF_FontHeight(txt->font));
+	if (txt->textImg)
+	{
+		copySurface(txt->textImg, NULL, img, 0, 0);
+		SDL_FreeSurface(txt->textImg);
+	}
+	txt->textImg = img;
+}
+
+void addWidget(UI *ui, Button *btn, TextField *txt, Rectangle bounds)
+{
+	if (ui->size == ui->capacity)
+	{
+		ui->capacity = ui->capacity ? 2 * ui->capacity : 16;
+		Widget *widgets = (Widget *)taggedMalloc(ui->capacity * sizeof(Widget), MEMORY_COMPONENTS);
+		if (ui->widgets) memcpy(widgets, ui->widgets, ui->size * sizeof(Widget));
+		taggedFree(ui->widgets);
+		ui->widgets = widgets;
+	}
+	Widget *w = &ui->widgets[ui->size++];
+	w->button = btn;
+	w->field = txt;
+	w->bounds = bounds;
+	ui->gridDirty = true;
+}
+
+void buildUIGrid(UI *ui)
+{
+	int i, col, line;
+	float left = 0, top = 0, right = 0, bottom = 0;
+	for (i = 0; i < ui->size; i++)
+	{
+		Rectangle r = ui->widgets[i].bounds;
+		if (i == 0 || r.position.x < left) left = r.position.x;
+		if (i == 0 || r.position.y < top) top = r.position.y;
+		if (i == 0 || r.position.x + r.size.x > right) right = r.position.x + r.size.x;
+		if (i == 0 || r.position.y + r.size.y > bottom) bottom = r.position.y + r.size.y;
+	}
+	ui->gridOrigin = newPoint(left, top);
+	ui->gridColumns = (int)((right - left) / UI_CELL_SIZE) + 1;
+	ui->gridLines = (int)((bottom - top) / UI_CELL_SIZE) + 1;
+	int cells = ui->gridColumns * ui->gridLines;
+
+	// Ordenação por contagem, como a grade de consultas de World: conta os componentes de cada célula, acumula os inícios e distribui os índices
+	taggedFree(ui->cellStart);
+	ui->cellStart = (int *)taggedMalloc((cells + 1) * sizeof(int), MEMORY_COMPONENTS);
+	memset(ui->cellStart, 0, (cells + 1) * sizeof(int));
+	for (i = 0; i < ui->size; i++)
+	{
+		Rectangle r = ui->widgets[i].bounds;
+		int col0 = (r.position.x - left) / UI_CELL_SIZE, col1 = (r.position.x + r.size.x - left) / UI_CELL_SIZE,
+			line0 = (r.position.y - top) / UI_CELL_SIZE, line1 = (r.position.y + r.size.y - top) / UI_CELL_SIZE;
+		for (line = line0; line <= line1; line++)
+			for (col = col0; col <= col1; col++)
+				ui->cellStart[col + line * ui->gridColumns + 1]++;
+	}
+	for (i = 0; i < cells; i++)
+		ui->cellStart[i + 1] += ui->cellStart[i];
+	taggedFree(ui->cellWidgets);
+	ui->cellWidgets = (int *)taggedMalloc((ui->cellStart[cells] + 1) * sizeof(int), MEMORY_COMPONENTS);
+	for (i = 0; i < ui->size; i++)
+	{
+		Rectangle r = ui->widgets[i].bounds;
+		int col0 = (r.position.x - left) / UI_CELL_SIZE, col1 = (r.position.x + r.size.x - left) / UI_CELL_SIZE,
+			line0 = (r.position.y - top) / UI_CELL_SIZE, line1 = (r.position.y + r.size.y - top) / UI_CELL_SIZE;
+		for (line = line0; line <= line1; line++)
+			for (col = col0; col <= col1; col++)
+				ui->cellWidgets[ui->cellStart[col + line * ui->gridColumns]++] = i;
+	}
+	for (i = cells; i > 0; i--)
+		ui->cellStart[i] = ui->cellStart[i - 1];
+	ui->cellStart[0] = 0;
+	ui->gridDirty = false;
+}
+
+int findWidget(UI *ui, Point pos)
+{
+	if (ui->size == 0 || pos.x < ui->gridOrigin.x || pos.y < ui->gridOrigin.y) return -1;
+	int col = (pos.x - ui->gridOrigin.x) / UI_CELL_SIZE, line = (pos.y - ui->gridOrigin.y) / UI_CELL_SIZE;
+	if (col >= ui->gridColumns || line >= ui->gridLines) return -1;
+
+	// Os índices de cada célula estão em ordem crescente; o último que contém o ponto é o que está por cima
+	int cell = col + line * ui->gridColumns, i;
+	for (i = ui->cellStart[cell + 1] - 1; i >= ui->cellStart[cell]; i--)
+	{
+		Rectangle r = ui->widgets[ui->cellWidgets[i]].bounds;
+		if (pos.x >= r.position.x && pos.x < r.position.x + r.size.x && pos.y >= r.position.y && pos.y < r.position.y + r.size.y)
+			return ui->cellWidgets[i];
+	}
+	return -1;
+}
+
+SDL_Surface *newAlphaSurface(int width, int height)
+{
+	Uint32 rmask, gmask, bmask, amask;
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+	rmask = 0xFF000000; gmask = 0x00FF0000; bmask = 0x0000FF00; amask = 0x000000FF;
+#else
+	rmask = 0x000000FF; gmask = 0x0000FF00; bmask = 0x00FF0000; amask = 0xFF000000;
+#endif
+	SDL_Surface *surface = SDL_CreateRGBSurface(SDL_SWSURFACE | SDL_SRCALPHA, width, height, 32, rmask, gmask, bmask, amask);
+	SDL_FillRect(surface, NULL, 0);
+	return surface;
+}
+
+void copySurface(SDL_Surface *src, SDL_Rect *section, SDL_Surface *dst, int x, int y)
+{
+	// Sem SDL_SRCALPHA na origem, a cópia leva também o canal alfa em vez de misturar as cores com o destino
+	Uint32 flags = src->flags & (SDL_SRCALPHA | SDL_RLEACCEL);
+	Uint8 alpha = src->format->alpha;
+	SDL_SetAlpha(src, 0, alpha);
+	SDL_Rect r = {x, y, 0, 0};
+	SDL_BlitSurface(src, section, dst, &r);
+	SDL_SetAlpha(src, flags, alpha);
+}
+
+SDL_Surface *optimizeSurface(SDL_Surface *surface)
+{
+	SDL_Surface *opt = SDL_DisplayFormatAlpha(surface);
+	if (!opt) return surface;
+	SDL_FreeSurface(surface);
+	return opt;
+}
+
+void buildButtonCache(Button *btn)
+{
+	Object *obj = btn->obj;
+	Rectangle frame = obj->rects[obj->imgIndex];
+	SDL_Rect section = {frame.position.x, frame.position.y, frame.size.x, frame.size.y};
+	if (btn->cache) SDL_FreeSurface(btn->cache);
+	btn->cache = newAlphaSurface(frame.size.x, frame.size.y);
+	copySurface(obj->image->surface, &section, btn->cache, 0, 0);
+	if (btn->text)
+	{
+		SDL_Rect r = {btn->textPos.x, btn->textPos.y, 0, 0};
+		SDL_BlitSurface(btn->textImg, NULL, btn->cache, &r);
+	}
+	btn->cache = optimizeSurface(btn->cache);
+	btn->dirty = false;
+}
+
+void buildTextFieldCache(TextField *txt)
+{
+	Object *box = txt->box;
+	if (txt->cache) SDL_FreeSurface(txt->cache);
+	txt->cache = newAlphaSurface(box->image->width, box->image->height);
+	copySurface(box->image->surface, NULL, txt->cache, 0, 0);
+	if (txt->length > 0)
+	{
+		SDL_Rect section = {0, 0, txt->glyphX[txt->length], txt->textImg->h}, r = {3, 3, 0, 0};
+		SDL_BlitSurface(txt->textImg, &section, txt->cache, &r);
+	}
+	if (txt->showCursor)
+	{
+		Rectangle cursor = getBounds(txt->cursor), bounds = getBounds(box);
+		SDL_Rect r = {roundFloat(cursor.position.x - txt->cursor->boundsPos.x - bounds.position.x + box->boundsPos.x),
+			roundFloat(cursor.position.y - txt->cursor->boundsPos.y - bounds.position.y + box->boundsPos.y), 0, 0};
+		SDL_BlitSurface(txt->cursor->image->surface, NULL, txt->cache, &r);
+	}
+	txt->cache = optimizeSurface(txt->cache);
+	txt->dirty = false;
+}
@@ -20,12 +20,12 @@
 /// Representa o estado de um botão (Button) quando o mouse completa um clique sobre ele
 #define BUTTON_STATE_CLICKED 4
 
-/// Total de teclas que são processadas pelos campos de texto (TextField)
-#define NUM_VALID_KEYS 48
-
 /// Intervalo em frames (o jogo roda aproximadamente a 60 frames por segundo) entre cada piscada do cursor de um campo de texto  (TextField)
 #define CURSOR_BLINK_INTERVAL 40
 
+/// Lado, em pixels, das células da grade usada por uma interface (UI) para encontrar o componente sob o mouse
+#define UI_CELL_SIZE 64
+
 /// Estrutura representando um botão
 typedef struct {
 	/// Objeto que representa o botão
@@ -42,6 +42,12 @@ typedef struct {
 	
 	/// Estado atual do botão, assumindo os valores BUTTON_STATE_UP, BUTTON_STATE_OVER, BUTTON_STATE_DOWN, BUTTON_STATE_DOWN_OUT ou  BUTTON_STATE_CLICKED
 	byte state;
+
+	/// Imagem do botão no estado atual já combinada com o texto, desenhada com uma única cópia
+	SDL_Surface *cache;
+
+	/// Verdadeiro se a aparência do botão mudou desde o último desenho e 'cache' precisa ser refeita
+	bool dirty;
 } Button;
 
 /// Estrutura representando um campo de texto
@@ -55,10 +61,10 @@ typedef struct {
 	/// Fonte usada para o texto
 	Font *font;
 	
-	/// Texto do campo
+	/// Texto do campo, codificado em UTF-8
 	char *text;
 	
-	/// Superfície contendo o texto renderizado
+	/// Superfície contendo o texto renderizado. Cada caractere digitado é desenhado nela individualmente, e ela pode ser mais larga que o texto
 	SDL_Surface *textImg;
 	
 	/// Cor do texto
@@ -66,6 +72,18 @@ typedef struct {
 	
 	/// Comprimento (número de caracteres) atual do texto
 	byte length;
+
+	/// Total de bytes usados pelo texto
+	short textBytes;
+
+	/// Posição x de cada caractere em 'textImg'. glyphX[length] é a largura do texto
+	short *glyphX;
+
+	/// Tecla do último caractere digitado ou apagado, que é repetido enquanto a tecla estiver segurada (ver setKeyboardParameters)
+	Key heldKey;
+
+	/// Caractere repetido enquanto 'heldKey' estiver segurada, ou '\b' para apagar
+	Uint16 heldChar;
 	
 	/// Comprimento máximo permitido para o texto
 	byte maxLength;
@@ -75,8 +93,61 @@ typedef struct {
 	
 	/// Determina se o cursor deve ser desenhado no frame atual
 	bool showCursor;
+
+	/// Imagem do campo já combinada com o texto e o cursor, desenhada com uma única cópia
+	SDL_Surface *cache;
+
+	/// Verdadeiro se o texto ou o cursor mudaram desde o último desenho e 'cache' precisa ser refeita
+	bool dirty;
 } TextField;
 
+/// Componente de uma interface (UI): um botão ou um campo de texto
+typedef struct {
+	/// Botão do componente, ou nulo se for um campo de texto
+	Button *button;
+
+	/// Campo de texto do componente, ou nulo se for um botão
+	TextField *field;
+
+	/// Área do componente na tela
+	Rectangle bounds;
+} Widget;
+
+/// Interface que reúne botões e campos de texto e os atualiza e desenha de uma vez. Os componentes ficam numa grade uniforme, de modo que a cada movimento do mouse apenas o componente sob ele é encontrado, e apenas ele e o componente que estava sob o mouse antes são atualizados. O teclado vai para o campo de texto em foco, escolhido com um clique
+typedef struct {
+	/// Componentes, na ordem em que foram adicionados. Componentes adicionados depois ficam por cima
+	Widget *widgets;
+
+	/// Total de componentes
+	int size;
+
+	/// Total de componentes que cabem em 'widgets' sem realocação
+	int capacity;
+
+	/// Posição do canto superior esquerdo da grade e total de colunas e linhas, com células de UI_CELL_SIZE pixels
+	Point gridOrigin;
+	int gridColumns, gridLines;
+
+	/// Para cada célula c, os índices dos componentes que a interceptam estão em cellWidgets[cellStart[c]] até cellWidgets[cellStart[c + 1] - 1], em ordem crescente
+	int *cellStart;
+	int *cellWidgets;
+
+	/// Verdadeiro se a grade precisa ser remontada (após a adição de componentes)
+	bool gridDirty;
+
+	/// Índice do componente sob o mouse, ou -1
+	int hovered;
+
+	/// Índice do botão pressionado que aguarda o mouse ser solto, ou -1
+	int pressed;
+
+	/// Campo de texto que recebe o teclado, ou nulo
+	TextField *focus;
+
+	/// Posição do mouse na última atualização
+	Point lastMouse;
+} UI;
+
 /// Cria um botão com os parâmetros especificados
 ///
 /// @param pos Posição da tela onde o botão será desenhado
@@ -103,17 +174,17 @@ TextField *newTextField(Point pos, Image *box, Image *cursor, byte maxLength, Fo
 /// @param btn O botão a ser atualizado
 void updateButton(Button *btn);
 
-/// Realiza toda a lógica de atualização do campo de texto, atualizando o texto em si e fazendo a animação do cursor
+/// Realiza toda a lógica de atualização do campo de texto, atualizando o texto em si e fazendo a animação do cursor. Todos os caracteres digitados no frame (ver getInputEvent) são acrescentados, e apenas eles são renderizados
 ///
 /// @param txt O campo de texto a ser atualizado
 void updateTextField(TextField *txt);
 
-/// Desenha um botão na tela
+/// Desenha um botão na tela. A imagem do botão combinada com o texto só é refeita quando a aparência muda
 ///
 /// @param btn O botão a ser desenhado
 void drawButton(Button *btn);
 
-/// Desenha um campo de texto na tela
+/// Desenha um campo de texto na tela. A imagem do campo combinada com o texto e o cursor só é refeita quando algum deles muda
 ///
 /// @param txt O campo de texto a ser desenhado
 void drawTextField(TextField *txt);
@@ -128,5 +199,43 @@ void freeButton(Button *btn);
 /// @param txt O campo de texto a ser deletado
 void freeTextField(TextField *txt);
 
+/// Cria uma interface vazia
+///
+/// @return A interface gerada
+UI *newUI();
+
+/// Adiciona um botão a uma interface, que passa a ser responsável por atualizá-lo, desenhá-lo e liberá-lo. O botão não deve mudar de posição depois de adicionado
+///
+/// @param ui Interface onde o botão será adicionado
+/// @param btn Botão a adicionar
+void addButtonToUI(UI *ui, Button *btn);
+
+/// Adiciona um campo de texto a uma interface, que passa a ser responsável por atualizá-lo, desenhá-lo e liberá-lo. O primeiro campo adicionado recebe o foco. O campo não deve mudar de posição depois de adicionado
+///
+/// @param ui Interface onde o campo será adicionado
+/// @param txt Campo de texto a adicionar
+void addTextFieldToUI(UI *ui, TextField *txt);
+
+/// Atualiza uma interface: encontra o componente sob o mouse quando ele se move, atualiza os botões afetados e o campo de texto em foco
+///
+/// @param ui Interface a ser atualizada
+void updateUI(UI *ui);
+
+/// Desenha todos os componentes de uma interface, com uma cópia da imagem combinada de cada um
+///
+/// @param ui Interface a ser desenhada
+void drawUI(UI *ui);
+
+/// Desenha apenas os componentes de uma interface cuja aparência mudou desde o último desenho, e marca suas áreas com markScreenArea. Junto com setPartialPresentation, permite que um menu parado não custe quase nada por frame: a tela não deve ser limpa, e os componentes devem ser opacos, já que cada um é desenhado sobre a sua imagem anterior
+///
+/// @param ui Interface a ser desenhada
+/// @return Total de componentes desenhados
+int drawChangedUI(UI *ui);
+
+/// Libera a memória usada por uma interface e por todos os seus componentes
+///
+/// @param ui Interface a ser deletada
+void freeUI(UI *ui);
+
 #endif
 
@@ -1,11 +1,43 @@
+#include <stdarg.h>
+#include <time.h>
 #include "control.h"
 
+#define FRAME_ALIGN 16
+
+int filterEvent(const SDL_Event *event);
+bool convertEvent(const SDL_Event *event, InputEvent *input);
+void applyInputEvent(InputEvent *input);
+void voiceFinished(int voice);
+void measureMix(void *data, Uint8 *stream, int length);
+void unlinkVoice(int voice);
+
 SDL_Surface *screen;
 SDL_Rect screenRect;
-Uint8 *keys, *prevKeys, keyHeldDelay, keyHeldInterval, mouseHeldDelay, mouseHeldInterval;
-Uint8 mouse, prevMouse;
-int numKeys, *keyTimers, mouseX, mouseY, *mouseTimers, ms;
+Uint8 keyHeldDelay, keyHeldInterval, mouseHeldDelay, mouseHeldInterval;
+Uint8 mouse;
+int mouseX, mouseY, *mouseTimers, ms;
+Uint32 keyBits[(SDLK_LAST + 31) / 32];
+int keyPressFrame[SDLK_LAST], keyReleaseFrame[SDLK_LAST], mousePressFrame[3], mouseReleaseFrame[3], frameNumber;
+InputEvent inputEvents[INPUT_EVENT_CAPACITY];
+Uint32 inputWritten, inputFrameStart, inputFrameEnd;
+Point eventPosition;
+Uint64 frameStartTime;
+FrameStats frameStats;
+int numVoices, numFreeVoices, *freeVoices, *voiceNext, *voicePrev, voiceHead[SOUND_PRIORITIES], voiceTail[SOUND_PRIORITIES];
+signed char *voicePriority;
+Sound *recentSounds[SOUND_RECENT_SIZE];
+int recentFrames[SOUND_RECENT_SIZE], recentVoices[SOUND_RECENT_SIZE];
+AudioStats audioStats;
+Uint64 lastMixTime, lastMixCpuTime, totalCallbackTime;
+void (*postMix)(void *data, Uint8 *stream, int length);
+void *postMixData;
+bool partialPresentation;
+SDL_Rect *presentRects;
+int numPresentRects, presentRectsCapacity;
 bool *mouseDouble;
+Uint8 *frameArena;
+size_t frameArenaSize, frameArenaUsed, frameArenaDemand;
+void *frameOverflow;
 
 void initializeVideo(const char *windowTitle, const char *icon, Point size, bool fullScreen)
 {
@@ -29,41 +61,85 @@ void initializeVideo(const char *windowTitle, const char *icon, Point size, bool
 
 void initializeAudio()
 {
-	Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 4096);
-	Mix_AllocateChannels(SOUND_CHANNELS);
+	initializeAudioSettings(getDefaultAudioSettings());
+}
+
+void initializeAudioSettings(AudioSettings settings)
+{
+	if (numVoices > 0) Mix_CloseAudio();
+	if (Mix_OpenAudio(settings.frequency, settings.format, settings.channels, settings.bufferSize) < 0)
+		printf("Erro ao iniciar o áudio: %s\n", Mix_GetError());
+	resetAudioStats();
+	Mix_SetPostMix(measureMix, NULL);
+	Mix_ChannelFinished(voiceFinished);
+	setSoundVoices(numVoices > 0 ? numVoices : SOUND_CHANNELS);
+}
+
+AudioSettings getDefaultAudioSettings()
+{
+	AudioSettings settings = {44100, MIX_DEFAULT_FORMAT, 2, 4096};
+	return settings;
+}
+
+AudioSettings getLowLatencyAudioSettings()
+{
+	AudioSettings settings = {44100, MIX_DEFAULT_FORMAT, 2, 512};
+	return settings;
 }
 
 void initializeInput()
 {
-	keys = SDL_GetKeyState(&numKeys);
-	prevKeys = (Uint8 *)safeMalloc(numKeys);
-	keyTimers = (int *)calloc(sizeof(int), numKeys);
+	// Teclas já pressionadas na inicialização contam como seguradas desde antes do primeiro frame
+	int numKeys, i;
+	Uint8 *keys = SDL_GetKeyState(&numKeys);
+	memset(keyBits, 0, sizeof(keyBits));
+	for (i = 0; i < SDLK_LAST; i++)
+	{
+		keyPressFrame[i] = keyReleaseFrame[i] = -1;
+		if (i < numKeys && keys[i]) keyBits[i / 32] |= 1u << (i % 32);
+	}
+	frameNumber = 0;
 	keyHeldDelay = 40;
 	keyHeldInterval = 5;
 	mouse = SDL_GetMouseState(&mouseX, &mouseY);
-	mouseTimers = (int *)calloc(sizeof(int), 3);
-	mouseDouble = (bool *)calloc(sizeof(bool), 3);
+	eventPosition = newPoint(mouseX, mouseY);
+	for (i = 0; i < 3; i++)
+		mousePressFrame[i] = mouseReleaseFrame[i] = -1;
+	mouseTimers = (int *)taggedMalloc(3 * sizeof(int), MEMORY_CONTROL);
+	mouseDouble = (bool *)taggedMalloc(3 * sizeof(bool), MEMORY_CONTROL);
+	memset(mouseTimers, 0, 3 * sizeof(int));
+	memset(mouseDouble, 0, 3 * sizeof(bool));
 	mouseHeldDelay = 40;
 	mouseHeldInterval = 5;
+	inputWritten = inputFrameStart = inputFrameEnd = 0;
+	SDL_SetEventFilter(filterEvent);
+	SDL_EnableUNICODE(1);
 }
 
 bool startFrame()
 {
 	ms = SDL_GetTicks();
+	frameStartTime = getMicroseconds();
+	frameNumber++;
 
-	memcpy(prevKeys, keys, numKeys);
-	prevMouse = mouse;
+	// Os eventos que chegaram desde o frame anterior passam a ser os eventos deste frame, aplicados na ordem de chegada
+	SDL_PumpEvents();
+	inputFrameStart = inputFrameEnd;
+	inputFrameEnd = inputWritten;
+	Uint32 e;
+	for (e = inputFrameStart; e != inputFrameEnd; e++)
+		applyInputEvent(&inputEvents[e % INPUT_EVENT_CAPACITY]);
 
+	// Restam na fila da SDL apenas os eventos que não são de entrada e os que não couberam no buffer
 	SDL_Event event;
+	InputEvent input;
 	while (SDL_PollEvent(&event))
+	{
 		if (event.type == SDL_QUIT) return true;
-	mouse = SDL_GetMouseState(&mouseX, &mouseY);
-
-	int i = 0;
-	for (i = 0; i < numKeys; i++)
-		if (isKeyDown(i)) keyTimers[i]++;
-		else keyTimers[i] = 0;
+		if (convertEvent(&event, &input)) applyInputEvent(&input);
+	}
 
+	int i;
 	for (i = 0; i < 3; i++)
 	{
 		if (isMousePressed(i + 1))
@@ -83,11 +159,35 @@ bool startFrame()
 
 void endFrame()
 {
-	SDL_Flip(screen);
-	int frame = SDL_GetTicks() - ms, i;
-	if (frame < 17) SDL_Delay(17 - frame);
+	if (!partialPresentation) SDL_Flip(screen);
+	else if (numPresentRects > 0) SDL_UpdateRects(screen, numPresentRects, presentRects);
+	numPresentRects = 0;
+
+	// A latência de cada evento vai da chegada à SDL até a apresentação do frame que o tratou
+	Uint64 now = getMicroseconds(), total = 0;
+	Uint32 e;
+	frameStats.workTime = now - frameStartTime;
+	frameStats.inputEvents = inputFrameEnd - inputFrameStart;
+	frameStats.maxInputLatency = frameStats.averageInputLatency = 0;
+	for (e = inputFrameStart; e != inputFrameEnd; e++)
+	{
+		Uint32 latency = now - inputEvents[e % INPUT_EVENT_CAPACITY].time;
+		if (latency > frameStats.maxInputLatency) frameStats.maxInputLatency = latency;
+		total += latency;
+	}
+	if (frameStats.inputEvents > 0) frameStats.averageInputLatency = total / frameStats.inputEvents;
+
+	// A espera bombeia os eventos a cada milissegundo, para que cheguem ao buffer com o instante real em que ocorreram
+	while (SDL_GetTicks() - ms < 17)
+	{
+		SDL_PumpEvents();
+		SDL_Delay(1);
+	}
+	int i;
 	for (i = 0; i < 3; i++)
 		mouseDouble[i] = false;
+	resetFrameArena();
+	endMemoryFrame();
 }
 
 void runGameLoop(void (*updateFunc)(), void (*drawFunc)(), bool *end)
@@ -104,10 +204,77 @@ void runGameLoop(void (*updateFunc)(), void (*drawFunc)(), bool *end)
 
 void finalize()
 {
-	free(prevKeys);
+	taggedFree(mouseTimers);
+	taggedFree(mouseDouble);
+	taggedFree(presentRects);
+	presentRects = NULL;
+	presentRectsCapacity = 0;
+	resetFrameArena();
+	taggedFree(frameArena);
+	frameArena = NULL;
 	Mix_CloseAudio();
+	taggedFree(freeVoices);
+	taggedFree(voiceNext);
+	taggedFree(voicePrev);
+	taggedFree(voicePriority);
+	freeVoices = voiceNext = voicePrev = NULL;
+	voicePriority = NULL;
+	numVoices = 0;
 	TTF_Quit();
 	SDL_Quit();
+	reportMemoryLeaks();
+}
+
+void *frameMalloc(size_t size)
+{
+	size = (size + FRAME_ALIGN - 1) & ~(size_t)(FRAME_ALIGN - 1);
+	if (frameArena == NULL)
+	{
+		frameArenaSize = FRAME_ARENA_SIZE;
+		frameArena = (Uint8 *)taggedMalloc(frameArenaSize, MEMORY_CONTROL);
+	}
+	frameArenaDemand += size;
+	if (frameArenaUsed + size <= frameArenaSize)
+	{
+		void *p = frameArena + frameArenaUsed;
+		frameArenaUsed += size;
+		return p;
+	}
+
+	// Não coube: usa um bloco avulso, que será descartado no fim do frame junto com o crescimento da área principal
+	void **block = (void **)taggedMalloc(FRAME_ALIGN + size, MEMORY_CONTROL);
+	*block = frameOverflow;
+	frameOverflow = block;
+	return (Uint8 *)block + FRAME_ALIGN;
+}
+char *frameFormat(const char *format, ...)
+{
+	va_list args, copy;
+	va_start(args, format);
+	va_copy(copy, args);
+	int length = vsnprintf(NULL, 0, format, copy);
+	va_end(copy);
+	char *text = (char *)frameMalloc(length + 1);
+	vsnprintf(text, length + 1, format, args);
+	va_end(args);
+	return text;
+}
+void resetFrameArena()
+{
+	while (frameOverflow)
+	{
+		void *next = *(void **)frameOverflow;
+		taggedFree(frameOverflow);
+		frameOverflow = next;
+	}
+	if (frameArenaDemand > frameArenaSize)
+	{
+		while (frameArenaSize < frameArenaDemand)
+			frameArenaSize *= 2;
+		taggedFree(frameArena);
+		frameArena = (Uint8 *)taggedMalloc(frameArenaSize, MEMORY_CONTROL);
+	}
+	frameArenaUsed = frameArenaDemand = 0;
 }
 
 void setFullScreen(bool fullScreen)
@@ -115,6 +282,39 @@ void setFullScreen(bool fullScreen)
 	screen = SDL_SetVideoMode(screenRect.w, screenRect.h, 0, SDL_ANYFORMAT | SDL_SWSURFACE | (fullScreen ? SDL_FULLSCREEN : 0));
 }
 
+Rectangle getScreenBounds()
+{
+	return newRectangle(screenRect.x, screenRect.y, screenRect.w, screenRect.h);
+}
+void setPartialPresentation(bool partial)
+{
+	partialPresentation = partial;
+	numPresentRects = 0;
+}
+void markScreenArea(Rectangle area)
+{
+	if (!partialPresentation) return;
+
+	// SDL_UpdateRects exige retângulos inteiramente dentro da tela
+	int x0 = area.position.x, y0 = area.position.y, x1 = area.position.x + area.size.x, y1 = area.position.y + area.size.y;
+	if (x0 < 0) x0 = 0;
+	if (y0 < 0) y0 = 0;
+	if (x1 > screenRect.w) x1 = screenRect.w;
+	if (y1 > screenRect.h) y1 = screenRect.h;
+	if (x0 >= x1 || y0 >= y1) return;
+
+	if (numPresentRects == presentRectsCapacity)
+	{
+		presentRectsCapacity = presentRectsCapacity ? 2 * presentRectsCapacity : 64;
+		SDL_Rect *rects = (SDL_Rect *)taggedMalloc(presentRectsCapacity * sizeof(SDL_Rect), MEMORY_CONTROL);
+		if (presentRects) memcpy(rects, presentRects, numPresentRects * sizeof(SDL_Rect));
+		taggedFree(presentRects);
+		presentRects = rects;
+	}
+	SDL_Rect r = {x0, y0, x1 - x0, y1 - y0};
+	presentRects[numPresentRects++] = r;
+}
+
 void clearScreen()
 {
 	SDL_FillRect(screen, &screenRect, SDL_MapRGB(screen->format, 0, 0, 0));
@@ -167,19 +367,22 @@ void setKeyboardParameters(Uint8 heldDelay, Uint8 heldInterval)
 }
 bool isKeyDown(Key key)
 {
-	return keys[key];
+	return (keyBits[key / 32] >> (key % 32)) & 1;
 }
 bool isKeyPressed(Key key)
 {
-	return keys[key] & !(prevKeys[key]);
+	return keyPressFrame[key] == frameNumber;
 }
 bool isKeyReleased(Key key)
 {
-	return prevKeys[key] & !(keys[key]);
+	return keyReleaseFrame[key] == frameNumber;
 }
 bool isKeyHeld(Key key)
 {
-	return (keyTimers[key] >= keyHeldDelay) && ((keyTimers[key] - keyHeldDelay) % keyHeldInterval == 0);
+	// Total de frames desde o pressionamento, contando o próprio frame do pressionamento
+	if (!isKeyDown(key)) return false;
+	int frames = frameNumber - keyPressFrame[key] + 1;
+	return frames >= keyHeldDelay && (frames - keyHeldDelay) % keyHeldInterval == 0;
 }
 
 void setMouseParameters(Uint8 heldDelay, Uint8 heldInterval)
@@ -205,11 +408,11 @@ bool isMouseDown(Uint8 button)
 }
 bool isMousePressed(Uint8 button)
 {
-	return (mouse & SDL_BUTTON(button)) && !(prevMouse & SDL_BUTTON(button));
+	return mousePressFrame[button-1] == frameNumber;
 }
 bool isMouseReleased(Uint8 button)
 {
-	return (prevMouse & SDL_BUTTON(button)) && !(mouse & SDL_BUTTON(button));
+	return mouseReleaseFrame[button-1] == frameNumber;
 }
 bool isMouseHeld(Uint8 button)
 {
@@ -220,26 +423,266 @@ bool isMouseDoubleClicked(Uint8 button)
 	return mouseDouble[button-1];
 }
 
+Uint64 getMicroseconds()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (Uint64)t.tv_sec * 1000000 + t.tv_nsec / 1000;
+}
+int getInputEventCount()
+{
+	return inputFrameEnd - inputFrameStart;
+}
+InputEvent *getInputEvent(int index)
+{
+	return &inputEvents[(inputFrameStart + index) % INPUT_EVENT_CAPACITY];
+}
+FrameStats getFrameStats()
+{
+	return frameStats;
+}
+
+int filterEvent(const SDL_Event *event)
+{
+	// Chamada pela SDL assim que o evento é recebido. Se o buffer estiver cheio, o evento segue pela fila da SDL e é tratado sem o instante de chegada
+	if (inputWritten - inputFrameStart >= INPUT_EVENT_CAPACITY) return 1;
+	if (!convertEvent(event, &inputEvents[inputWritten % INPUT_EVENT_CAPACITY])) return 1;
+	inputWritten++;
+	return 0;
+}
+
+bool convertEvent(const SDL_Event *event, InputEvent *input)
+{
+	input->time = getMicroseconds();
+	input->key = SDLK_UNKNOWN;
+	input->unicode = 0;
+	input->button = 0;
+	// Eventos de teclado levam a posição do último evento de mouse convertido, e não a aplicada no frame anterior
+	input->position = eventPosition;
+	switch (event->type)
+	{
+	case SDL_KEYDOWN:
+	case SDL_KEYUP:
+		input->type = event->type == SDL_KEYDOWN ? INPUT_KEY_DOWN : INPUT_KEY_UP;
+		input->key = event->key.keysym.sym;
+		if (event->type == SDL_KEYDOWN) input->unicode = event->key.keysym.unicode;
+		return true;
+	case SDL_MOUSEMOTION:
+		input->type = INPUT_MOUSE_MOTION;
+		input->position = eventPosition = newPoint(event->motion.x, event->motion.y);
+		return true;
+	case SDL_MOUSEBUTTONDOWN:
+	case SDL_MOUSEBUTTONUP:
+		input->type = event->type == SDL_MOUSEBUTTONDOWN ? INPUT_MOUSE_DOWN : INPUT_MOUSE_UP;
+		input->button = event->button.button;
+		input->position = eventPosition = newPoint(event->button.x, event->button.y);
+		return true;
+	}
+	return false;
+}
+
+void applyInputEvent(InputEvent *input)
+{
+	// Apenas as teclas e botões que mudaram de estado são tocados: o frame do pressionamento ou da soltura fica registrado, e as demais consultas são calculadas a partir dele
+	Key key = input->key;
+	Uint32 bit = 1u << (key % 32);
+	int b = input->button - 1;
+	switch (input->type)
+	{
+	case INPUT_KEY_DOWN:
+		if (keyBits[key / 32] & bit) break;
+		keyBits[key / 32] |= bit;
+		keyPressFrame[key] = frameNumber;
+		break;
+	case INPUT_KEY_UP:
+		if (!(keyBits[key / 32] & bit)) break;
+		keyBits[key / 32] &= ~bit;
+		keyReleaseFrame[key] = frameNumber;
+		break;
+	case INPUT_MOUSE_MOTION:
+		break;
+	case INPUT_MOUSE_DOWN:
+		if (b >= 3 || (mouse & SDL_BUTTON(input->button))) break;
+		mouse |= SDL_BUTTON(input->button);
+		mousePressFrame[b] = frameNumber;
+		break;
+	case INPUT_MOUSE_UP:
+		if (b >= 3 || !(mouse & SDL_BUTTON(input->button))) break;
+		mouse &= ~SDL_BUTTON(input->button);
+		mouseReleaseFrame[b] = frameNumber;
+		break;
+	}
+	if (input->type != INPUT_KEY_DOWN && input->type != INPUT_KEY_UP)
+	{
+		mouseX = input->position.x;
+		mouseY = input->position.y;
+	}
+}
+
 Sound *newSound(const char *fileName)
 {
 	return Mix_LoadWAV(fileName);
 }
 void playSound(Sound *sound, float volume)
 {
-	Mix_VolumeChunk(sound, volume * MIX_MAX_VOLUME);
+	playSoundVoice(sound, volume, 0, SOUND_PRIORITY_NORMAL);
+}
+int playSoundVoice(Sound *sound, float volume, float pan, int priority)
+{
+	if (priority < 0) priority = 0;
+	if (priority >= SOUND_PRIORITIES) priority = SOUND_PRIORITIES - 1;
 
-	byte i;
-	for (i = 0; i < SOUND_CHANNELS; i++)
-		if (!Mix_Playing(i))
+	// Tabela de espalhamento, indexada pelo endereço do som, dos sons já tocados neste frame. Entradas de frames anteriores contam como vazias
+	int slot = (((size_t)sound >> 4) * 2654435761u) % SOUND_RECENT_SIZE, probe;
+	for (probe = 0; probe < SOUND_RECENT_SIZE; probe++, slot = (slot + 1) % SOUND_RECENT_SIZE)
+		if (recentFrames[slot] != frameNumber || recentSounds[slot] == sound) break;
+	if (probe < SOUND_RECENT_SIZE && recentFrames[slot] == frameNumber)
+	{
+		// A voz pode ter terminado ou sido reaproveitada por outro som desde então; nesse caso o som é tocado de novo
+		int voice = recentVoices[slot];
+		SDL_LockAudio();
+		bool playing = voice >= 0 && Mix_Playing(voice) && Mix_GetChunk(voice) == sound;
+		if (playing && volume * MIX_MAX_VOLUME > Mix_Volume(voice, -1)) Mix_Volume(voice, volume * MIX_MAX_VOLUME);
+		SDL_UnlockAudio();
+		if (playing || voice < 0) return voice;
+	}
+
+	// A função de fim de canal roda na thread de áudio, com o áudio travado; as listas só são alteradas aqui com o mesmo travamento
+	SDL_LockAudio();
+	if (numFreeVoices == 0)
+	{
+		int level;
+		for (level = 0; level <= priority && voiceHead[level] < 0; level++);
+		if (level > priority)
 		{
-			Mix_PlayChannel(i, sound, 0);
-			return;
+			SDL_UnlockAudio();
+			return -1;
 		}
+		// Interromper a voz chama voiceFinished, que a devolve à pilha de vozes livres
+		Mix_HaltChannel(voiceHead[level]);
+	}
+	int voice = freeVoices[--numFreeVoices];
+	voicePriority[voice] = priority;
+	voiceNext[voice] = -1;
+	voicePrev[voice] = voiceTail[priority];
+	if (voiceTail[priority] >= 0) voiceNext[voiceTail[priority]] = voice;
+	else voiceHead[priority] = voice;
+	voiceTail[priority] = voice;
+
+	Mix_Volume(voice, volume * MIX_MAX_VOLUME);
+	Mix_SetPanning(voice, pan > 0 ? 255 * (1 - pan) : 255, pan < 0 ? 255 * (1 + pan) : 255);
+	if (Mix_PlayChannel(voice, sound, 0) < 0)
+	{
+		unlinkVoice(voice);
+		freeVoices[numFreeVoices++] = voice;
+		voice = -1;
+	}
+	SDL_UnlockAudio();
+
+	if (probe < SOUND_RECENT_SIZE)
+	{
+		recentSounds[slot] = sound;
+		recentFrames[slot] = frameNumber;
+		recentVoices[slot] = voice;
+	}
+	return voice;
+}
+void setSoundVoices(int voices)
+{
+	Mix_HaltChannel(-1);
+	SDL_LockAudio();
+	taggedFree(freeVoices);
+	taggedFree(voiceNext);
+	taggedFree(voicePrev);
+	taggedFree(voicePriority);
+	freeVoices = (int *)taggedMalloc(voices * sizeof(int), MEMORY_CONTROL);
+	voiceNext = (int *)taggedMalloc(voices * sizeof(int), MEMORY_CONTROL);
+	voicePrev = (int *)taggedMalloc(voices * sizeof(int), MEMORY_CONTROL);
+	voicePriority = (signed char *)taggedMalloc(voices, MEMORY_CONTROL);
+	int i;
+	for (i = 0; i < voices; i++)
+	{
+		freeVoices[i] = voices - 1 - i;
+		voicePriority[i] = -1;
+	}
+	for (i = 0; i < SOUND_PRIORITIES; i++)
+		voiceHead[i] = voiceTail[i] = -1;
+	numVoices = numFreeVoices = voices;
+	SDL_UnlockAudio();
+	Mix_AllocateChannels(voices);
+	clearRecentSounds();
+}
+void clearRecentSounds()
+{
+	memset(recentFrames, 0xFF, sizeof(recentFrames));
 }
 void freeSound(Sound *sound)
 {
 	Mix_FreeChunk(sound);
 }
+AudioStats getAudioStats()
+{
+	SDL_LockAudio();
+	AudioStats stats = audioStats;
+	if (stats.callbacks > 0) stats.averageCallbackTime = totalCallbackTime / stats.callbacks;
+	SDL_UnlockAudio();
+	return stats;
+}
+void resetAudioStats()
+{
+	SDL_LockAudio();
+	memset(&audioStats, 0, sizeof(audioStats));
+	lastMixTime = lastMixCpuTime = totalCallbackTime = 0;
+	SDL_UnlockAudio();
+}
+void setAudioPostMix(void (*func)(void *data, Uint8 *stream, int length), void *data)
+{
+	SDL_LockAudio();
+	postMix = func;
+	postMixData = data;
+	SDL_UnlockAudio();
+}
+void measureMix(void *data, Uint8 *stream, int length)
+{
+	// Chamada pelo SDL_mixer na thread de áudio ao final de cada mistura. O tempo de CPU da thread entre duas misturas é o custo de cada callback, já que a espera pelo dispositivo não consome CPU
+	struct timespec t;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+	Uint64 now = getMicroseconds(), cpu = (Uint64)t.tv_sec * 1000000 + t.tv_nsec / 1000;
+	int frequency, channels;
+	Uint16 format;
+	Mix_QuerySpec(&frequency, &format, &channels);
+	audioStats.period = (Uint64)length * 1000000 / (channels * ((format & 0xFF) / 8) * frequency);
+
+	if (lastMixTime > 0)
+	{
+		Uint32 interval = now - lastMixTime, callback = cpu - lastMixCpuTime;
+		if (interval > audioStats.maxInterval) audioStats.maxInterval = interval;
+		if (2 * interval > 3 * audioStats.period) audioStats.underruns++;
+		if (callback > audioStats.maxCallbackTime) audioStats.maxCallbackTime = callback;
+		totalCallbackTime += callback;
+		audioStats.callbacks++;
+	}
+	lastMixTime = now;
+	lastMixCpuTime = cpu;
+	audioStats.activeVoices = numVoices - numFreeVoices;
+	if (audioStats.activeVoices > audioStats.maxActiveVoices) audioStats.maxActiveVoices = audioStats.activeVoices;
+	if (postMix) postMix(postMixData, stream, length);
+}
+void voiceFinished(int voice)
+{
+	if (voice >= numVoices || voicePriority[voice] < 0) return;
+	unlinkVoice(voice);
+	freeVoices[numFreeVoices++] = voice;
+}
+void unlinkVoice(int voice)
+{
+	int priority = voicePriority[voice];
+	if (voicePrev[voice] >= 0) voiceNext[voicePrev[voice]] = voiceNext[voice];
+	else voiceHead[priority] = voiceNext[voice];
+	if (voiceNext[voice] >= 0) voicePrev[voiceNext[voice]] = voicePrev[voice];
+	else voiceTail[priority] = voicePrev[voice];
+	voicePriority[voice] = -1;
+}
 
 Music *newMusic(const char *fileName)
 {
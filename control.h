@@ -13,9 +13,120 @@
 #define Sound Mix_Chunk
 #define Music Mix_Music
 
-/// Total de canais de som (que determina a quantidade de sons simultâneos) disponibilizados para o jogo
+/// Total de canais de som (que determina a quantidade de sons simultâneos) disponibilizados para o jogo. Pode ser alterado com setSoundVoices
 #define SOUND_CHANNELS 5
 
+/// Total de níveis de prioridade dos sons (ver playSoundVoice). Os níveis vão de 0 (menor) a SOUND_PRIORITIES - 1 (maior)
+#define SOUND_PRIORITIES 4
+
+/// Prioridade usada por playSound
+#define SOUND_PRIORITY_NORMAL 1
+
+/// Total de sons distintos cuja repetição no mesmo frame é detectada (ver playSoundVoice)
+#define SOUND_RECENT_SIZE 64
+
+/// Capacidade inicial, em bytes, da memória temporária de frame (ver frameMalloc)
+#define FRAME_ARENA_SIZE 65536
+
+/// Total de eventos de entrada guardados entre dois frames (ver getInputEvent). Eventos além desse total continuam sendo tratados, mas não entram no buffer
+#define INPUT_EVENT_CAPACITY 512
+
+/// Tipo de um evento de entrada
+typedef enum {
+	/// Tecla pressionada
+	INPUT_KEY_DOWN,
+
+	/// Tecla solta
+	INPUT_KEY_UP,
+
+	/// Movimento do mouse
+	INPUT_MOUSE_MOTION,
+
+	/// Botão do mouse pressionado
+	INPUT_MOUSE_DOWN,
+
+	/// Botão do mouse solto
+	INPUT_MOUSE_UP
+} InputEventType;
+
+/// Evento de entrada recebido durante um frame, com o instante em que chegou à SDL
+typedef struct {
+	/// Tipo do evento
+	InputEventType type;
+
+	/// Instante de chegada do evento, em microssegundos (ver getMicroseconds)
+	Uint64 time;
+
+	/// Tecla do evento, para INPUT_KEY_DOWN e INPUT_KEY_UP
+	Key key;
+
+	/// Caractere digitado (código Unicode), para INPUT_KEY_DOWN. Zero se a tecla não gera caractere
+	Uint16 unicode;
+
+	/// Botão do mouse do evento, para INPUT_MOUSE_DOWN e INPUT_MOUSE_UP
+	Uint8 button;
+
+	/// Posição do mouse no instante do evento
+	Point position;
+} InputEvent;
+
+/// Parâmetros de abertura do mixer de áudio (ver initializeAudioSettings)
+typedef struct {
+	/// Frequência de amostragem, em Hz
+	int frequency;
+
+	/// Formato das amostras (por exemplo, MIX_DEFAULT_FORMAT)
+	Uint16 format;
+
+	/// Total de canais de saída (1 para mono, 2 para estéreo)
+	int channels;
+
+	/// Tamanho do buffer de áudio, em amostras por canal. Deve ser potência de 2. A latência entre tocar um som e ouvi-lo é de pelo menos bufferSize / frequency segundos
+	int bufferSize;
+} AudioSettings;
+
+/// Medidas do mixer de áudio, coletadas na thread de áudio ao final de cada mistura (ver getAudioStats)
+typedef struct {
+	/// Total de misturas (chamadas do callback de áudio) desde a abertura do áudio ou desde resetAudioStats
+	int callbacks;
+
+	/// Duração de áudio de cada buffer, em microssegundos
+	Uint32 period;
+
+	/// Maior intervalo entre duas misturas consecutivas, em microssegundos
+	Uint32 maxInterval;
+
+	/// Total de intervalos entre misturas maiores que 1,5 vezes a duração do buffer: o dispositivo provavelmente ficou sem amostras e houve falha audível
+	int underruns;
+
+	/// Tempo médio de CPU gasto pela thread de áudio a cada mistura, em microssegundos
+	Uint32 averageCallbackTime;
+
+	/// Maior tempo de CPU gasto pela thread de áudio numa mistura, em microssegundos
+	Uint32 maxCallbackTime;
+
+	/// Vozes tocando na última mistura
+	int activeVoices;
+
+	/// Maior número de vozes tocando numa mistura
+	int maxActiveVoices;
+} AudioStats;
+
+/// Medidas de tempo do último frame completo do laço principal, em microssegundos
+typedef struct {
+	/// Tempo desde o início do frame (leitura da entrada) até o fim da apresentação na tela, sem a espera pelo próximo frame
+	Uint32 workTime;
+
+	/// Total de eventos de entrada tratados no frame
+	int inputEvents;
+
+	/// Maior latência de entrada do frame: tempo desde a chegada de um evento à SDL até a apresentação do frame que o tratou
+	Uint32 maxInputLatency;
+
+	/// Latência média dos eventos de entrada do frame
+	Uint32 averageInputLatency;
+} FrameStats;
+
 /// Inicializa o subsistema de vídeo da SDL, juntamente com o sistema SDL_TTF
 ///
 /// @param windowTitle Título para a janela do jogo
@@ -24,9 +135,38 @@
 /// @param fullScreen Determina se o jogo deve ser aberto em full screen
 void initializeVideo(const char *windowTitle, const char *icon, Point size, bool fullScreen);
 
-/// Inicializa o sistema de audio SDL_Mixer
+/// Inicializa o sistema de audio SDL_Mixer com os parâmetros padrão (ver getDefaultAudioSettings)
 void initializeAudio();
 
+/// Inicializa o sistema de audio SDL_Mixer com os parâmetros dados. Pode ser chamada novamente para reabrir o áudio com outros parâmetros, o que interrompe todos os sons. A biblioteca instala sua própria função de pós-mistura para coletar as medidas de getAudioStats: o jogo não deve chamar Mix_SetPostMix, e sim setAudioPostMix
+///
+/// @param settings Parâmetros do mixer
+void initializeAudioSettings(AudioSettings settings);
+
+/// Retorna os parâmetros padrão do áudio: 44100 Hz, estéreo, buffer de 4096 amostras (cerca de 93 ms)
+///
+/// @return Os parâmetros padrão
+AudioSettings getDefaultAudioSettings();
+
+/// Retorna parâmetros de baixa latência para o áudio: 44100 Hz, estéreo, buffer de 512 amostras (cerca de 12 ms). Buffers pequenos exigem que a thread de áudio nunca atrase; use getAudioStats para verificar se há falhas
+///
+/// @return Os parâmetros de baixa latência
+AudioSettings getLowLatencyAudioSettings();
+
+/// Retorna as medidas do mixer de áudio
+///
+/// @return Medidas acumuladas desde a abertura do áudio ou desde resetAudioStats
+AudioStats getAudioStats();
+
+/// Zera as medidas do mixer de áudio
+void resetAudioStats();
+
+/// Define uma função chamada na thread de áudio ao final de cada mistura, como em Mix_SetPostMix, depois da coleta das medidas de getAudioStats
+///
+/// @param func Função que recebe 'data', as amostras misturadas e o seu tamanho em bytes. Pode ser nula
+/// @param data Parâmetro repassado para a função
+void setAudioPostMix(void (*func)(void *data, Uint8 *stream, int length), void *data);
+
 /// Inicializa o sistema de tratamento da entrada. Os códigos de teclas e botões do mouse estão definidos em 'support.h'
 void initializeInput();
 
@@ -40,11 +180,41 @@ void runGameLoop(void (*updateFunc)(), void (*drawFunc)(), bool *end);
 /// Finaliza todos os sistemas. Deve ser chamado após o término do laço principal do jogo
 void finalize();
 
+/// Aloca memória temporária que vale apenas até o fim do frame atual. Essa memória não deve ser liberada: ela é descartada em bloco ao final de cada frame do laço principal, e a capacidade cresce até comportar o uso de um frame, de modo que frames estáveis não fazem alocações no heap
+///
+/// @param size Espaço em bytes a ser alocado
+/// @return Ponteiro para o espaço alocado, alinhado para qualquer tipo
+void *frameMalloc(size_t size);
+
+/// Formata um texto (como printf) em memória temporária de frame. Útil para textos que são desenhados uma única vez, como placares
+///
+/// @param format Formato do texto, como em printf
+/// @return O texto formatado, válido até o fim do frame atual
+char *frameFormat(const char *format, ...);
+
+/// Descarta toda a memória temporária de frame. Chamada automaticamente ao final de cada frame do laço principal
+void resetFrameArena();
+
 /// Define o modo full screen
 ///
 /// @param fullScreen Verdadeiro para full screen, falso para janela
 void setFullScreen(bool fullScreen);
 
+/// Retorna a área da tela, usada por exemplo para descartar o desenho de objetos fora dela
+///
+/// @return Um retângulo com a posição (0, 0) e o tamanho da tela
+Rectangle getScreenBounds();
+
+/// Define se o final de cada frame apresenta a tela inteira (o padrão) ou apenas as áreas marcadas com markScreenArea durante o frame. Com a apresentação parcial, um frame em que nada foi marcado não copia nada para a janela. A tela não deve ser limpa a cada frame nesse modo, já que as áreas não marcadas continuam mostrando o que foi desenhado antes
+///
+/// @param partial Verdadeiro para apresentar apenas as áreas marcadas, falso para apresentar a tela inteira
+void setPartialPresentation(bool partial);
+
+/// Marca uma área da tela para ser apresentada ao final do frame atual, quando a apresentação parcial está ativa (ver setPartialPresentation)
+///
+/// @param area Área da tela que foi redesenhada
+void markScreenArea(Rectangle area);
+
 /// Limpa a tela com a cor padrão (preto)
 void clearScreen();
 
@@ -115,13 +285,13 @@ void setKeyboardParameters(Uint8 heldDelay, Uint8 heldInterval);
 /// @return Verdadeiro se a tecla 'key' está pressionada
 bool isKeyDown(Key key);
 
-/// Retorna se uma dada tecla foi pressionada no frame atual (não estava pressionada no frame anterior)
+/// Retorna se uma dada tecla foi pressionada no frame atual (não estava pressionada no frame anterior). Um toque que começa e termina dentro do mesmo frame também é detectado
 ///
 /// @param key Código da tecla a ser verificada
 /// @return Verdadeiro se a tecla 'key' foi pressionada nesse frame
 bool isKeyPressed(Key key);
 
-/// Retorna se uma dada tecla foi solta no frame atual (estava pressionada no frame anterior)
+/// Retorna se uma dada tecla foi solta no frame atual (estava pressionada no frame anterior, ou foi pressionada e solta dentro do frame)
 ///
 /// @param key Código da tecla a ser verificada
 /// @return Verdadeiro se a tecla 'key' foi solta nesse frame
@@ -179,18 +349,56 @@ bool isMouseHeld(Uint8 button);
 /// @return Verdadeiro se o botão 'button' completou duplo-clique nesse frame
 bool isMouseDoubleClicked(Uint8 button);
 
+/// Retorna o instante atual de um relógio monotônico de alta resolução
+///
+/// @return Tempo em microssegundos desde um instante arbitrário
+Uint64 getMicroseconds();
+
+/// Retorna o total de eventos de entrada do frame atual. Cada evento recebido desde o frame anterior é guardado, de modo que cliques e toques mais curtos que um frame e todo o trajeto do mouse ficam disponíveis, com o instante exato de cada um. Os eventos são lidos logo antes da função de atualização, e a espera entre frames continua recebendo-os a cada milissegundo
+///
+/// @return Total de eventos, que podem ser obtidos com getInputEvent
+int getInputEventCount();
+
+/// Retorna um evento de entrada do frame atual, na ordem de chegada
+///
+/// @param index Índice do evento, entre 0 e getInputEventCount() - 1
+/// @return O evento, válido até o fim do frame atual
+InputEvent *getInputEvent(int index);
+
+/// Retorna as medidas de tempo do último frame completo, incluindo a latência de entrada
+///
+/// @return Medidas do último frame
+FrameStats getFrameStats();
+
 /// Cria um som no sistema SDL_Mixer
 ///
 /// @param fileName Nome do arquivo de som (.wav, .ogg, entre outros)
 /// @return Um som numa estrutura Mix_Chunk (encapsulada como Sound)
 Sound *newSound(const char *fileName);
 
-/// Toca um som com o volume dado
+/// Toca um som com o volume dado, com prioridade SOUND_PRIORITY_NORMAL e sem deslocamento estéreo (ver playSoundVoice)
 ///
 /// @param sound Som a ser tocado
 /// @param volume Volume para tocar o som (valores entre 0 e 1, onde 0 é mudo e 1 é o volume máximo)
 void playSound(Sound *sound, float volume);
 
+/// Toca um som num canal (voz) livre. Se todos estiverem ocupados, a voz mais antiga do nível de prioridade mais baixo (que não seja maior que a do novo som) é interrompida e reaproveitada. O volume e o deslocamento estéreo são aplicados apenas à voz, sem alterar o som, que pode estar tocando em outras vozes. Se o mesmo som já foi tocado no frame atual e ainda está tocando, ele não é repetido: a voz existente é retornada, com o maior dos dois volumes
+///
+/// @param sound Som a ser tocado
+/// @param volume Volume para tocar o som (valores entre 0 e 1, onde 0 é mudo e 1 é o volume máximo)
+/// @param pan Deslocamento estéreo, de -1 (apenas à esquerda) a 1 (apenas à direita). Zero toca igualmente nos dois lados
+/// @param priority Prioridade do som, de 0 a SOUND_PRIORITIES - 1
+/// @return A voz usada, ou -1 se todas estavam ocupadas por sons de maior prioridade
+int playSoundVoice(Sound *sound, float volume, float pan, int priority);
+
+/// Define o total de vozes (canais de som simultâneos). Todos os sons sendo tocados são interrompidos. O padrão é SOUND_CHANNELS
+///
+/// @param voices Total de vozes
+void setSoundVoices(int voices);
+
+/// Esquece os sons tocados no frame atual, permitindo que playSoundVoice os toque de novo. O laço principal (runGameLoop) já faz isso a cada frame; a função só é necessária em programas que tocam sons sem ele
+void clearRecentSounds();
+
 /// Libera a memória usada por um som (estrutura Sound)
 ///
 /// @param sound Som a ser deletado
@@ -0,0 +1,213 @@
+#include "effect.h"
+#include "simd.h"
+
+typedef void (*IntegrateKernel)(Effect *effect);
+
+void growEffect(Effect *effect, int capacity);
+IntegrateKernel getIntegrateKernel();
+
+Effect *newEffect(Image *spriteSheet, byte columns, byte lines, int capacity, bool growable)
+{
+	Effect *effect = (Effect *)taggedMalloc(sizeof(*effect), MEMORY_PARTICLE);
+	effect->x = NULL;
+	effect->size = effect->capacity = 0;
+	effect->growable = growable;
+	effect->gravity = newPoint(0, 0);
+	effect->image = spriteSheet;
+	effect->rects = NULL;
+	effect->frames = 0;
+	effect->frameInterval = 1;
+	effect->color = newColor(255, 255, 255);
+	effect->pointSize = 2;
+	if (spriteSheet)
+	{
+		effect->frames = columns * lines;
+		effect->rects = (Rectangle *)taggedMalloc(effect->frames * sizeof(Rectangle), MEMORY_PARTICLE);
+		int i, j, w = spriteSheet->width / columns, h = spriteSheet->height / lines;
+		for (i = 0; i < columns; i++)
+			for (j = 0; j < lines; j++)
+				effect->rects[i + j * columns] = newRectangle(i * w, j * h, w, h);
+	}
+	growEffect(effect, capacity > 0 ? capacity : 8);
+	return effect;
+}
+
+int emitParticles(Effect *effect, int count, Point pos, Point minSpeed, Point maxSpeed, float minLife, float maxLife)
+{
+	if (effect->size + count > effect->capacity)
+	{
+		if (effect->growable)
+		{
+			int capacity = effect->capacity * 2;
+			while (capacity < effect->size + count)
+				capacity *= 2;
+			growEffect(effect, capacity);
+		}
+		else count = effect->capacity - effect->size;
+	}
+
+	// Os valores sorteados são escritos diretamente nos vetores, em bloco
+	Random *rng = getThreadRandom();
+	int first = effect->size, i;
+	fillRandomFloats(rng, effect->xSpeed + first, count, minSpeed.x, maxSpeed.x);
+	fillRandomFloats(rng, effect->ySpeed + first, count, minSpeed.y, maxSpeed.y);
+	fillRandomFloats(rng, effect->life + first, count, minLife, maxLife);
+	for (i = first; i < first + count; i++)
+	{
+		effect->x[i] = pos.x;
+		effect->y[i] = pos.y;
+		effect->age[i] = 0;
+	}
+	effect->size += count;
+	return count;
+}
+
+void updateEffect(Effect *effect)
+{
+	getIntegrateKernel()(effect);
+
+	// As partículas mortas são substituídas pelas últimas, mantendo os vetores contíguos
+	int i = 0;
+	while (i < effect->size)
+	{
+		if (effect->age[i] < effect->life[i])
+		{
+			i++;
+			continue;
+		}
+		int last = --effect->size;
+		effect->x[i] = effect->x[last];
+		effect->y[i] = effect->y[last];
+		effect->xSpeed[i] = effect->xSpeed[last];
+		effect->ySpeed[i] = effect->ySpeed[last];
+		effect->age[i] = effect->age[last];
+		effect->life[i] = effect->life[last];
+	}
+}
+
+void drawEffect(Effect *effect)
+{
+	Rectangle screenBounds = getScreenBounds();
+	float left = screenBounds.position.x, top = screenBounds.position.y,
+		right = left + screenBounds.size.x, bottom = top + screenBounds.size.y;
+	int i;
+
+	if (effect->image)
+	{
+		float w = effect->rects[0].size.x, h = effect->rects[0].size.y;
+		for (i = 0; i < effect->size; i++)
+		{
+			float x = effect->x[i] - w / 2, y = effect->y[i] - h / 2;
+			if (x + w <= left || x >= right || y + h <= top || y >= bottom) continue;
+			int frame = ((int)effect->age[i] / effect->frameInterval) % effect->frames;
+			drawSurfaceSection(effect->image->surface, effect->rects[frame], roundFloat(x), roundFloat(y));
+		}
+	}
+	else
+	{
+		// A cor é convertida para o formato da tela uma única vez para todo o efeito
+		SDL_Surface *screen = SDL_GetVideoSurface();
+		Uint32 color = SDL_MapRGB(screen->format, effect->color.r, effect->color.g, effect->color.b);
+		float half = effect->pointSize / 2.0f;
+		for (i = 0; i < effect->size; i++)
+		{
+			float x = effect->x[i] - half, y = effect->y[i] - half;
+			if (x + effect->pointSize <= left || x >= right || y + effect->pointSize <= top || y >= bottom) continue;
+			SDL_Rect r = {roundFloat(x), roundFloat(y), effect->pointSize, effect->pointSize};
+			SDL_FillRect(screen, &r, color);
+		}
+	}
+}
+
+void clearEffect(Effect *effect)
+{
+	effect->size = 0;
+}
+
+void freeEffect(Effect *effect)
+{
+	taggedFree(effect->x);
+	if (effect->rects) taggedFree(effect->rects);
+	taggedFree(effect);
+}
+
+void growEffect(Effect *effect, int capacity)
+{
+	capacity = (capacity + 7) & ~7;
+
+	// Os seis vetores ficam num único bloco. Os kernels processam 'capacity' posições, por isso o espaço além de 'size' é inicializado
+	float *block = (float *)taggedMalloc(6 * capacity * sizeof(float), MEMORY_PARTICLE);
+	memset(block, 0, 6 * capacity * sizeof(float));
+	float **fields[6] = {&effect->x, &effect->y, &effect->xSpeed, &effect->ySpeed, &effect->age, &effect->life};
+	int f;
+	if (effect->x)
+		for (f = 0; f < 6; f++)
+			memcpy(block + f * capacity, *fields[f], effect->size * sizeof(float));
+	taggedFree(effect->x);
+	for (f = 0; f < 6; f++)
+		*fields[f] = block + f * capacity;
+	effect->capacity = capacity;
+}
+
+void integrateScalar(Effect *effect)
+{
+	float gx = effect->gravity.x, gy = effect->gravity.y;
+	int i;
+	for (i = 0; i < effect->size; i++)
+	{
+		effect->xSpeed[i] += gx;
+		effect->ySpeed[i] += gy;
+		effect->x[i] += effect->xSpeed[i];
+		effect->y[i] += effect->ySpeed[i];
+		effect->age[i] += 1;
+	}
+}
+
+#ifdef MINI_X86
+__attribute__((target("sse2")))
+void integrateSSE(Effect *effect)
+{
+	__m128 gx = _mm_set1_ps(effect->gravity.x), gy = _mm_set1_ps(effect->gravity.y), one = _mm_set1_ps(1);
+	int i;
+	for (i = 0; i < effect->size; i += 4)
+	{
+		__m128 vx = _mm_add_ps(_mm_loadu_ps(effect->xSpeed + i), gx), vy = _mm_add_ps(_mm_loadu_ps(effect->ySpeed + i), gy);
+		_mm_storeu_ps(effect->xSpeed + i, vx);
+		_mm_storeu_ps(effect->ySpeed + i, vy);
+		_mm_storeu_ps(effect->x + i, _mm_add_ps(_mm_loadu_ps(effect->x + i), vx));
+		_mm_storeu_ps(effect->y + i, _mm_add_ps(_mm_loadu_ps(effect->y + i), vy));
+		_mm_storeu_ps(effect->age + i, _mm_add_ps(_mm_loadu_ps(effect->age + i), one));
+	}
+}
+
+__attribute__((target("avx")))
+void integrateAVX(Effect *effect)
+{
+	__m256 gx = _mm256_set1_ps(effect->gravity.x), gy = _mm256_set1_ps(effect->gravity.y), one = _mm256_set1_ps(1);
+	int i;
+	for (i = 0; i < effect->size; i += 8)
+	{
+		__m256 vx = _mm256_add_ps(_mm256_loadu_ps(effect->xSpeed + i), gx), vy = _mm256_add_ps(_mm256_loadu_ps(effect->ySpeed + i), gy);
+		_mm256_storeu_ps(effect->xSpeed + i, vx);
+		_mm256_storeu_ps(effect->ySpeed + i, vy);
+		_mm256_storeu_ps(effect->x + i, _mm256_add_ps(_mm256_loadu_ps(effect->x + i), vx));
+		_mm256_storeu_ps(effect->y + i, _mm256_add_ps(_mm256_loadu_ps(effect->y + i), vy));
+		_mm256_storeu_ps(effect->age + i, _mm256_add_ps(_mm256_loadu_ps(effect->age + i), one));
+	}
+}
+#endif
+
+IntegrateKernel getIntegrateKernel()
+{
+	static IntegrateKernel kernel = NULL;
+	if (kernel == NULL)
+	{
+#ifdef MINI_X86
+		SimdLevel simd = getSimdLevel();
+		kernel = simd == SIMD_AVX ? integrateAVX : simd == SIMD_SSE2 ? integrateSSE : integrateScalar;
+#else
+		kernel = integrateScalar;
+#endif
+	}
+	return kernel;
+}
@@ -0,0 +1,101 @@
+/** @file */
+
+#ifndef MINI_EFFECT_H
+#define MINI_EFFECT_H
+
+#include "control.h"
+
+/// Efeito visual com milhares de partículas simples (faíscas, fumaça, poeira), sem colisão. Cada partícula é apenas um ponto com velocidade e tempo de vida, e os dados de todas ficam em vetores separados (um para cada campo), atualizados em lote com instruções SIMD e desenhados numa única passada
+typedef struct {
+	/// Coordenada x de cada partícula
+	float *x;
+
+	/// Coordenada y de cada partícula
+	float *y;
+
+	/// Componente x da velocidade de cada partícula
+	float *xSpeed;
+
+	/// Componente y da velocidade de cada partícula
+	float *ySpeed;
+
+	/// Frames desde a criação de cada partícula
+	float *age;
+
+	/// Tempo de vida, em frames, de cada partícula
+	float *life;
+
+	/// Total de partículas vivas
+	int size;
+
+	/// Total de partículas que cabem nos vetores sem realocação. É sempre múltiplo de 8
+	int capacity;
+
+	/// Determina se a capacidade pode crescer quando o efeito estiver cheio. Se for falso, as partículas que não couberem não são criadas
+	bool growable;
+
+	/// Aceleração somada à velocidade de todas as partículas a cada frame (por exemplo, gravidade ou vento)
+	Point gravity;
+
+	/// Sprite sheet das partículas, ou nula para desenhá-las como quadrados de cor sólida
+	Image *image;
+
+	/// Retângulos de cada imagem da sprite sheet
+	Rectangle *rects;
+
+	/// Total de imagens da sprite sheet
+	int frames;
+
+	/// Frames que cada imagem da sprite sheet dura na animação das partículas
+	int frameInterval;
+
+	/// Cor das partículas quando não há sprite sheet
+	Color color;
+
+	/// Lado, em pixels, do quadrado desenhado para cada partícula quando não há sprite sheet
+	int pointSize;
+} Effect;
+
+/// Cria um efeito vazio
+///
+/// @param spriteSheet Sprite sheet das partículas, que deve continuar existindo enquanto o efeito for usado. Se for nula, as partículas são desenhadas como quadrados brancos de 2 pixels
+/// @param columns Número de colunas da sprite sheet
+/// @param lines Número de linhas da sprite sheet
+/// @param capacity Quantidade de partículas pré-alocadas
+/// @param growable Verdadeiro para permitir que o efeito cresça quando estiver cheio, falso para manter a capacidade fixa
+/// @return O efeito gerado
+Effect *newEffect(Image *spriteSheet, byte columns, byte lines, int capacity, bool growable);
+
+/// Cria partículas num ponto, com velocidades e tempos de vida sorteados em bloco pelo gerador de números aleatórios da thread atual
+///
+/// @param effect Efeito onde as partículas serão criadas
+/// @param count Quantidade de partículas
+/// @param pos Posição inicial das partículas
+/// @param minSpeed Menor velocidade em cada eixo
+/// @param maxSpeed Maior velocidade em cada eixo
+/// @param minLife Menor tempo de vida, em frames
+/// @param maxLife Maior tempo de vida, em frames
+/// @return Quantidade de partículas criadas, menor que 'count' se o efeito estiver cheio e não puder crescer
+int emitParticles(Effect *effect, int count, Point pos, Point minSpeed, Point maxSpeed, float minLife, float maxLife);
+
+/// Avança um frame: aplica a aceleração e a velocidade a todas as partículas e remove as que atingiram o tempo de vida. A ordem das partículas nos vetores pode mudar
+///
+/// @param effect Efeito a ser atualizado
+void updateEffect(Effect *effect);
+
+/// Desenha todas as partículas visíveis de um efeito
+///
+/// @param effect Efeito a ser desenhado
+void drawEffect(Effect *effect);
+
+/// Remove todas as partículas de um efeito
+///
+/// @param effect Efeito a ser limpo
+void clearEffect(Effect *effect);
+
+/// Libera a memória usada por um efeito. A sprite sheet não é liberada
+///
+/// @param effect Efeito a ser deletado
+void freeEffect(Effect *effect);
+
+#endif
@@ -0,0 +1,264 @@
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "level.h"
+
+int getSectorTileBytes(LevelHeader *header);
+Uint8 *getSectorData(Level *level, int index);
+void adviseSector(Level *level, int index, int advice);
+void loadSector(Level *level, int index);
+void spawnSectorObjects(Level *level, LoadedSector *loaded);
+void unloadSector(Level *level, int slot);
+void rebuildLevelTiles(Level *level);
+
+Level *loadLevel(const char *fileName)
+{
+	int file = open(fileName, O_RDONLY);
+	if (file < 0)
+	{
+		printf("Erro ao abrir a fase %s\n", fileName);
+		return NULL;
+	}
+	struct stat info;
+	void *data = MAP_FAILED;
+	if (fstat(file, &info) == 0 && (size_t)info.st_size >= sizeof(LevelHeader))
+		data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED)
+	{
+		printf("Erro ao ler a fase %s\n", fileName);
+		return NULL;
+	}
+
+	// Os dados de cada setor só são conferidos quando ele é carregado, para não percorrer o arquivo inteiro
+	LevelHeader *header = (LevelHeader *)data;
+	if (memcmp(header->magic, LEVEL_MAGIC, 4) != 0 || header->version != LEVEL_VERSION || header->sectorSize == 0 ||
+		!(header->tileSize.x > 0 && header->tileSize.y > 0) ||
+		header->sectorColumns != (header->columns + header->sectorSize - 1) / header->sectorSize ||
+		header->sectorLines != (header->lines + header->sectorSize - 1) / header->sectorSize ||
+		sizeof(LevelHeader) + (size_t)header->sectorColumns * header->sectorLines * sizeof(LevelSector) > (size_t)info.st_size ||
+		header->tileset[LEVEL_PATH_SIZE - 1] != '\0' || (header->layers > 0 && header->tilesetColumns * header->tilesetLines == 0))
+	{
+		printf("Fase inválida: %s\n", fileName);
+		munmap(data, info.st_size);
+		return NULL;
+	}
+
+	Level *level = (Level *)taggedMalloc(sizeof(*level), MEMORY_OBJECT);
+	level->data = (Uint8 *)data;
+	level->size = info.st_size;
+	level->header = header;
+	level->sectors = (LevelSector *)(level->data + sizeof(LevelHeader));
+	level->tileset = header->layers > 0 ? newImage(header->tileset) : NULL;
+	level->tiles = newTileMap(newPoint(0, 0), header->tileSize, 0, 0);
+	level->loaded = NULL;
+	level->numLoaded = level->loadedCapacity = 0;
+	level->column0 = level->line0 = 0;
+	level->column1 = level->line1 = -1;
+	level->margin = 1;
+	level->spawn = NULL;
+	level->despawn = NULL;
+	level->callbackData = NULL;
+	return level;
+}
+
+void setLevelCallbacks(Level *level, Object *(*spawn)(LevelObjectInfo *info, void *data),
+	void (*despawn)(Object *obj, LevelObjectInfo *info, void *data), void *data)
+{
+	level->spawn = spawn;
+	level->despawn = despawn;
+	level->callbackData = data;
+
+	// Setores carregados antes de haver uma função de criação ganham seus objetos agora
+	int i;
+	for (i = 0; i < level->numLoaded; i++)
+		spawnSectorObjects(level, &level->loaded[i]);
+}
+
+void updateLevel(Level *level, Rectangle view)
+{
+	LevelHeader *header = level->header;
+	float sectorWidth = header->sectorSize * header->tileSize.x, sectorHeight = header->sectorSize * header->tileSize.y;
+	int column0 = (int)floorf(view.position.x / sectorWidth) - level->margin,
+		line0 = (int)floorf(view.position.y / sectorHeight) - level->margin,
+		column1 = (int)floorf((view.position.x + view.size.x) / sectorWidth) + level->margin,
+		line1 = (int)floorf((view.position.y + view.size.y) / sectorHeight) + level->margin;
+	if (column0 < 0) column0 = 0;
+	if (line0 < 0) line0 = 0;
+	if (column1 >= (int)header->sectorColumns) column1 = header->sectorColumns - 1;
+	if (line1 >= (int)header->sectorLines) line1 = header->sectorLines - 1;
+	if (column0 > column1 || line0 > line1)
+	{
+		column0 = line0 = 0;
+		column1 = line1 = -1;
+	}
+	if (column0 == level->column0 && line0 == level->line0 && column1 == level->column1 && line1 == level->line1) return;
+
+	// Descarrega os setores que saíram da área e carrega os que entraram, sem tocar nos que continuam carregados
+	int i, column, line;
+	for (i = level->numLoaded - 1; i >= 0; i--)
+	{
+		column = level->loaded[i].index % header->sectorColumns;
+		line = level->loaded[i].index / header->sectorColumns;
+		if (column < column0 || column > column1 || line < line0 || line > line1) unloadSector(level, i);
+	}
+	for (line = line0; line <= line1; line++)
+		for (column = column0; column <= column1; column++)
+			if (column < level->column0 || column > level->column1 || line < level->line0 || line > level->line1)
+				loadSector(level, column + line * header->sectorColumns);
+	level->column0 = column0;
+	level->line0 = line0;
+	level->column1 = column1;
+	level->line1 = line1;
+	rebuildLevelTiles(level);
+}
+
+void drawLevelLayer(Level *level, int layer, Rectangle view)
+{
+	LevelHeader *header = level->header;
+	if (layer < 0 || layer >= (int)header->layers || !level->tileset) return;
+	int size = header->sectorSize, imageWidth = level->tileset->width / header->tilesetColumns,
+		imageHeight = level->tileset->height / header->tilesetLines;
+	Point tileSize = header->tileSize;
+	int i, column, line;
+	for (i = 0; i < level->numLoaded; i++)
+	{
+		int index = level->loaded[i].index;
+		Uint8 *data = getSectorData(level, index);
+		if (!data) continue;
+
+		// Faixa de células do setor visíveis na área
+		int firstColumn = (index % header->sectorColumns) * size, firstLine = (index / header->sectorColumns) * size,
+			column0 = (int)floorf(view.position.x / tileSize.x) - firstColumn,
+			line0 = (int)floorf(view.position.y / tileSize.y) - firstLine,
+			column1 = (int)floorf((view.position.x + view.size.x) / tileSize.x) - firstColumn,
+			line1 = (int)floorf((view.position.y + view.size.y) / tileSize.y) - firstLine;
+		if (column0 < 0) column0 = 0;
+		if (line0 < 0) line0 = 0;
+		if (column1 >= size) column1 = size - 1;
+		if (line1 >= size) line1 = size - 1;
+
+		Uint16 *cells = (Uint16 *)(data + size * ((size + 31) / 32) * sizeof(Uint32)) + layer * size * size;
+		for (line = line0; line <= line1; line++)
+			for (column = column0; column <= column1; column++)
+			{
+				int cell = cells[column + line * size] - 1;
+				if (cell < 0) continue;
+				Rectangle section = newRectangle((cell % header->tilesetColumns) * imageWidth, (cell / header->tilesetColumns) * imageHeight,
+					imageWidth, imageHeight);
+				drawSurfaceSection(level->tileset->surface, section, roundFloat((firstColumn + column) * tileSize.x - view.position.x),
+					roundFloat((firstLine + line) * tileSize.y - view.position.y));
+			}
+	}
+}
+
+void freeLevel(Level *level)
+{
+	while (level->numLoaded > 0)
+		unloadSector(level, level->numLoaded - 1);
+	freeTileMap(level->tiles);
+	if (level->tileset) freeImage(level->tileset);
+	munmap(level->data, level->size);
+	taggedFree(level->loaded);
+	taggedFree(level);
+}
+
+int getSectorTileBytes(LevelHeader *header)
+{
+	// Solidez e camadas, arredondadas para que os objetos fiquem alinhados
+	int size = header->sectorSize;
+	return (size * ((size + 31) / 32) * sizeof(Uint32) + header->layers * size * size * sizeof(Uint16) + 3) & ~3;
+}
+
+Uint8 *getSectorData(Level *level, int index)
+{
+	LevelSector *sector = &level->sectors[index];
+	if (sector->offset == 0 ||
+		(size_t)sector->offset + getSectorTileBytes(level->header) + (size_t)sector->objects * sizeof(LevelObjectInfo) > level->size)
+		return NULL;
+	return level->data + sector->offset;
+}
+
+void adviseSector(Level *level, int index, int advice)
+{
+	// Os dados de cada setor começam numa página própria, e nenhuma de suas páginas é compartilhada com outro setor
+	LevelSector *sector = &level->sectors[index];
+	if (!getSectorData(level, index)) return;
+	madvise(level->data + sector->offset, getSectorTileBytes(level->header) + sector->objects * sizeof(LevelObjectInfo), advice);
+}
+
+void loadSector(Level *level, int index)
+{
+	if (level->numLoaded == level->loadedCapacity)
+	{
+		level->loadedCapacity = level->loadedCapacity > 0 ? 2 * level->loadedCapacity : 16;
+		LoadedSector *loaded = (LoadedSector *)taggedMalloc(level->loadedCapacity * sizeof(LoadedSector), MEMORY_OBJECT);
+		if (level->loaded) memcpy(loaded, level->loaded, level->numLoaded * sizeof(LoadedSector));
+		taggedFree(level->loaded);
+		level->loaded = loaded;
+	}
+	LoadedSector *loaded = &level->loaded[level->numLoaded++];
+	loaded->index = index;
+	loaded->objects = NULL;
+
+	adviseSector(level, index, MADV_WILLNEED);
+	spawnSectorObjects(level, loaded);
+}
+
+void spawnSectorObjects(Level *level, LoadedSector *loaded)
+{
+	Uint8 *data = getSectorData(level, loaded->index);
+	int count = level->sectors[loaded->index].objects, i;
+	if (!data || count == 0 || !level->spawn || loaded->objects) return;
+	LevelObjectInfo *infos = (LevelObjectInfo *)(data + getSectorTileBytes(level->header));
+	loaded->objects = (Object **)taggedMalloc(count * sizeof(Object *), MEMORY_OBJECT);
+	for (i = 0; i < count; i++)
+		loaded->objects[i] = level->spawn(&infos[i], level->callbackData);
+}
+
+void unloadSector(Level *level, int slot)
+{
+	LoadedSector *loaded = &level->loaded[slot];
+	Uint8 *data = getSectorData(level, loaded->index);
+	if (loaded->objects)
+	{
+		LevelObjectInfo *infos = (LevelObjectInfo *)(data + getSectorTileBytes(level->header));
+		int i;
+		for (i = 0; i < (int)level->sectors[loaded->index].objects; i++)
+			if (loaded->objects[i] && level->despawn) level->despawn(loaded->objects[i], &infos[i], level->callbackData);
+		taggedFree(loaded->objects);
+	}
+
+	// As páginas do setor podem ser descartadas: continuam no arquivo e são lidas de novo se ele voltar a ser carregado
+	adviseSector(level, loaded->index, MADV_DONTNEED);
+	*loaded = level->loaded[--level->numLoaded];
+}
+
+void rebuildLevelTiles(Level *level)
+{
+	LevelHeader *header = level->header;
+	int size = header->sectorSize, words = (size + 31) / 32;
+	resizeTileMap(level->tiles, newPoint(level->column0 * size * header->tileSize.x, level->line0 * size * header->tileSize.y),
+		(level->column1 - level->column0 + 1) * size, (level->line1 - level->line0 + 1) * size);
+
+	int i, line, w;
+	for (i = 0; i < level->numLoaded; i++)
+	{
+		int index = level->loaded[i].index;
+		Uint32 *solid = (Uint32 *)getSectorData(level, index);
+		if (!solid) continue;
+		int firstColumn = (index % header->sectorColumns - level->column0) * size, firstLine = (index / header->sectorColumns - level->line0) * size;
+		for (line = 0; line < size; line++)
+			for (w = 0; w < words; w++)
+			{
+				Uint32 bits = solid[line * words + w];
+				while (bits)
+				{
+					setTileSolid(level->tiles, firstColumn + w * 32 + __builtin_ctz(bits), firstLine + line, true);
+					bits &= bits - 1;
+				}
+			}
+	}
+}
@@ -0,0 +1,161 @@
+/** @file */
+
+#ifndef MINI_LEVEL_H
+#define MINI_LEVEL_H
+
+#include "tilemap.h"
+
+/// Identificação dos arquivos de fase
+#define LEVEL_MAGIC "MLVL"
+
+/// Versão atual do formato dos arquivos de fase
+#define LEVEL_VERSION 1
+
+/// Tamanho máximo, incluindo o terminador, do nome do arquivo de imagem do tileset de uma fase
+#define LEVEL_PATH_SIZE 64
+
+/// Alinhamento, em bytes, dos dados de cada setor dentro do arquivo. Por ser o tamanho de página usual, cada setor ocupa páginas próprias, que podem ser descartadas da memória quando o setor é descarregado
+#define LEVEL_SECTOR_ALIGN 4096
+
+/// Cabeçalho de um arquivo de fase, seguido pela tabela de setores (LevelSector), linha por linha, e pelos dados de cada setor. Os números estão na ordem de bytes da máquina que gerou o arquivo
+typedef struct {
+	/// Identificação do formato (LEVEL_MAGIC)
+	char magic[4];
+
+	/// Versão do formato (LEVEL_VERSION)
+	Uint32 version;
+
+	/// Largura (tileSize.x) e altura (tileSize.y) de cada célula
+	Point tileSize;
+
+	/// Quantidade de colunas e linhas de células da fase inteira
+	Uint32 columns, lines;
+
+	/// Lado de cada setor, em células
+	Uint32 sectorSize;
+
+	/// Quantidade de colunas e linhas de setores
+	Uint32 sectorColumns, sectorLines;
+
+	/// Quantidade de camadas de desenho
+	Uint32 layers;
+
+	/// Nome do arquivo de imagem do tileset usado pelas camadas, ou vazio se não houver camadas
+	char tileset[LEVEL_PATH_SIZE];
+
+	/// Colunas e linhas do tileset
+	Uint32 tilesetColumns, tilesetLines;
+} LevelHeader;
+
+/// Entrada de um setor na tabela de setores. Os dados de um setor são a solidez de suas células (sectorSize linhas de (sectorSize + 31) / 32 palavras de 32 bits), as células de cada camada (sectorSize * sectorSize valores de 16 bits por camada, linha por linha, sendo 0 uma célula vazia e i + 1 a imagem i do tileset) e os objetos (LevelObjectInfo)
+typedef struct {
+	/// Posição dos dados do setor, em bytes desde o início do arquivo, sempre múltiplo de LEVEL_SECTOR_ALIGN. Zero se o setor for inteiramente vazio
+	Uint32 offset;
+
+	/// Total de objetos do setor
+	Uint32 objects;
+} LevelSector;
+
+/// Objeto de uma fase. A biblioteca não sabe o que cada objeto representa: ela o repassa ao jogo quando o setor onde ele começa é carregado (ver setLevelCallbacks)
+typedef struct {
+	/// Tipo do objeto, definido pelo jogo
+	Uint32 type;
+
+	/// Posição do objeto
+	Point position;
+
+	/// Tamanho do objeto
+	Point size;
+
+	/// Valor adicional, com significado definido pelo jogo
+	Sint32 param;
+} LevelObjectInfo;
+
+/// Setor carregado de uma fase
+typedef struct {
+	/// Índice do setor na tabela de setores
+	int index;
+
+	/// Objetos criados pelo jogo para o setor, na ordem de LevelObjectInfo. Podem ser nulos
+	Object **objects;
+} LoadedSector;
+
+/// Fase num arquivo binário mapeado em memória (mmap), dividida em setores quadrados com células de colisão, camadas de desenho e objetos. Apenas os setores próximos da área visível ficam carregados (ver updateLevel): a memória usada e o tempo de carga dependem da área visível e não do tamanho da fase. Os arquivos são gerados pela ferramenta tools/levelbuilder
+typedef struct {
+	/// Conteúdo do arquivo, mapeado em memória
+	Uint8 *data;
+
+	/// Tamanho do arquivo, em bytes
+	size_t size;
+
+	/// Cabeçalho, dentro de 'data'
+	LevelHeader *header;
+
+	/// Tabela de setores, dentro de 'data'
+	LevelSector *sectors;
+
+	/// Tileset das camadas, ou nulo se não houver camadas
+	Image *tileset;
+
+	/// Grade de colisão com as células dos setores carregados. Sua posição e tamanho acompanham a área carregada, mas o ponteiro não muda, e pode ser passado uma única vez para setWorldTiles
+	TileMap *tiles;
+
+	/// Setores carregados
+	LoadedSector *loaded;
+
+	/// Total de setores carregados
+	int numLoaded;
+
+	/// Total de setores que cabem em 'loaded' sem realocação
+	int loadedCapacity;
+
+	/// Primeira e última coluna e linha de setores carregados. Nenhum setor está carregado se a última coluna for menor que a primeira
+	int column0, line0, column1, line1;
+
+	/// Quantidade de setores carregados além dos que interceptam a área visível, em cada direção. O padrão é 1
+	int margin;
+
+	/// Função chamada para criar o objeto de cada LevelObjectInfo de um setor carregado, ou nula
+	Object *(*spawn)(LevelObjectInfo *info, void *data);
+
+	/// Função chamada para cada objeto criado por 'spawn' quando seu setor é descarregado, ou nula
+	void (*despawn)(Object *obj, LevelObjectInfo *info, void *data);
+
+	/// Parâmetro repassado para 'spawn' e 'despawn'
+	void *callbackData;
+} Level;
+
+/// Carrega uma fase. Nenhum setor é carregado até a primeira chamada de updateLevel
+///
+/// @param fileName Nome do arquivo da fase
+/// @return A fase carregada, ou nula se o arquivo não puder ser lido ou for inválido
+Level *loadLevel(const char *fileName);
+
+/// Define as funções que criam e destroem os objetos de uma fase quando os setores são carregados e descarregados. Os objetos pertencem sempre ao setor onde começam, mesmo que se movam. Cabe ao jogo adicioná-los e removê-los de um mundo físico (ver World). Se já houver setores carregados, seus objetos ainda não criados são criados imediatamente; objetos já criados continuam existindo e serão destruídos pela nova função 'despawn'
+///
+/// @param level Fase a ser alterada
+/// @param spawn Função chamada para criar o objeto de cada LevelObjectInfo. Pode retornar nulo para ignorar o objeto
+/// @param despawn Função chamada para cada objeto criado quando seu setor é descarregado, responsável por liberá-lo
+/// @param data Parâmetro repassado para as funções
+void setLevelCallbacks(Level *level, Object *(*spawn)(LevelObjectInfo *info, void *data),
+	void (*despawn)(Object *obj, LevelObjectInfo *info, void *data), void *data);
+
+/// Carrega os setores próximos de uma área e descarrega os demais. Só faz alguma coisa quando a área muda de setor, e pode ser chamada a cada frame. Ao carregar ou descarregar setores, a grade de colisão 'tiles' é refeita para cobrir os setores carregados
+///
+/// @param level Fase a ser atualizada
+/// @param view Área visível da fase
+void updateLevel(Level *level, Rectangle view);
+
+/// Desenha a parte de uma camada da fase que intercepta a área visível. Apenas os setores carregados são desenhados
+///
+/// @param level Fase a ser desenhada
+/// @param layer Índice da camada
+/// @param view Área visível da fase. O canto superior esquerdo da área é desenhado no canto superior esquerdo da tela
+void drawLevelLayer(Level *level, int layer, Rectangle view);
+
+/// Libera uma fase, descarregando todos os setores (o que chama 'despawn' para seus objetos) e a grade de colisão. A grade não pode mais estar sendo usada por um mundo físico
+///
+/// @param level Fase a ser deletada
+void freeLevel(Level *level);
+
+#endif
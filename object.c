@@ -1,5 +1,8 @@
 #include "object.h"
 
+Rectangle getDrawnBounds(Object *obj);
+void drawVisibleObject(Object *obj);
+
 Object *newBlock(Point pos, Image *img)
 {
 	return newObject(pos, newPoint(img->width, img->height), newPoint(0, 0), img);
@@ -7,11 +10,13 @@ Object *newBlock(Point pos, Image *img)
 
 Object *newObject(Point pos, Point size, Point boundsPos, Image *img)
 {
-	Object *obj = (Object *)safeMalloc(sizeof(*obj));
+	Object *obj = (Object *)taggedMalloc(sizeof(*obj), MEMORY_OBJECT);
 	obj->bounds = newRectangle(pos.x, pos.y, size.x, size.y);
 	obj->boundsPos = boundsPos;
 	obj->image = img;
 	obj->rects = NULL;
+	obj->category = 1;
+	obj->collisionMask = 0xFFFFFFFF;
 	return obj;
 }
 
@@ -23,16 +28,18 @@ Object *newBlockSprite(Point pos, Image *spriteSheet, byte columns, byte lines)
 
 Object *newSprite(Point pos, Point size, Point boundsPos, Image *spriteSheet, byte columns, byte lines)
 {
-	Object *obj = (Object *)safeMalloc(sizeof(*obj));
+	Object *obj = (Object *)taggedMalloc(sizeof(*obj), MEMORY_OBJECT);
 	obj->bounds = newRectangle(pos.x, pos.y, size.x, size.y);
 	obj->boundsPos = boundsPos;
 	obj->image = spriteSheet;
-	obj->rects = (Rectangle *)safeMalloc(columns * lines * sizeof(Rectangle));
+	obj->rects = (Rectangle *)taggedMalloc(columns * lines * sizeof(Rectangle), MEMORY_OBJECT);
 	obj->columns = columns;
 	obj->lines = lines;
 	obj->imgIndex = 0;
 	obj->imgTimer = 0;
 	obj->animIndex = 0;
+	obj->category = 1;
+	obj->collisionMask = 0xFFFFFFFF;
 	int i, j, w = spriteSheet->width / columns, h = spriteSheet->height / lines;
 	for (i = 0; i < columns; i++)
 		for (j = 0; j < lines; j++)
@@ -40,6 +47,12 @@ Object *newSprite(Point pos, Point size, Point boundsPos, Image *spriteSheet, by
 	return obj;
 }
 
+void setCollisionLayers(Object *obj, Uint32 category, Uint32 collisionMask)
+{
+	obj->category = category;
+	obj->collisionMask = collisionMask;
+}
+
 Rectangle getBounds(Object *obj)
 {
 	return obj->bounds;
@@ -121,22 +134,52 @@ void animate(Object *obj, byte *indices, byte size, byte interval)
 
 void drawObject(Object *obj)
 {
-	if (obj->image)
+	if (obj->image && intersects(getDrawnBounds(obj), getScreenBounds()))
+		drawVisibleObject(obj);
+}
+
+void drawObjects(Object **objects, int count)
+{
+	RectangleArray drawn;
+	drawn.capacity = (count + 31) & ~31;
+	drawn.left = (float *)frameMalloc(4 * drawn.capacity * sizeof(float));
+	drawn.top = drawn.left + drawn.capacity;
+	drawn.right = drawn.top + drawn.capacity;
+	drawn.bottom = drawn.right + drawn.capacity;
+	drawn.size = 0;
+
+	int i;
+	for (i = 0; i < count; i++)
+		setRectangle(&drawn, drawn.size++, objects[i]->image ? getDrawnBounds(objects[i]) : newRectangle(0, 0, 0, 0));
+
+	Uint32 *visible = (Uint32 *)frameMalloc((drawn.capacity / 32 + 1) * sizeof(Uint32));
+	intersectsMask(getScreenBounds(), &drawn, visible);
+	for (i = 0; i < count; i++)
+		if (visible[i / 32] & (1u << (i % 32)))
+			drawVisibleObject(objects[i]);
+}
+
+Rectangle getDrawnBounds(Object *obj)
+{
+	Point size = obj->rects ? obj->rects[obj->imgIndex].size : newPoint(obj->image->width, obj->image->height);
+	return newRectangle(obj->bounds.position.x - obj->boundsPos.x, obj->bounds.position.y - obj->boundsPos.y, size.x, size.y);
+}
+
+void drawVisibleObject(Object *obj)
+{
+	if (obj->rects)
 	{
-		if (obj->rects)
-		{
-			Rectangle r = obj->rects[obj->imgIndex];
-			drawSurfaceSection(obj->image->surface, r,
-				roundFloat(obj->bounds.position.x - obj->boundsPos.x), roundFloat(obj->bounds.position.y - obj->boundsPos.y));
-		}
-		else drawSurface(obj->image->surface,
+		Rectangle r = obj->rects[obj->imgIndex];
+		drawSurfaceSection(obj->image->surface, r,
 			roundFloat(obj->bounds.position.x - obj->boundsPos.x), roundFloat(obj->bounds.position.y - obj->boundsPos.y));
 	}
+	else drawSurface(obj->image->surface,
+		roundFloat(obj->bounds.position.x - obj->boundsPos.x), roundFloat(obj->bounds.position.y - obj->boundsPos.y));
 }
 
 void freeObject(Object *obj)
 {
 	if (obj->image) freeImage(obj->image);
-	if (obj->rects) free(obj->rects);
-	free(obj);
+	if (obj->rects) taggedFree(obj->rects);
+	taggedFree(obj);
 }
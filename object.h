@@ -4,6 +4,7 @@
 #define MINI_OBJECT_H
 
 #include "control.h"
+#include "rectarray.h"
 
 /// Estrutura que representa um objeto de jogo, em geral definido por uma posição, caixa de colisão e imagem
 typedef struct {
@@ -33,6 +34,12 @@ typedef struct {
 	
 	/// Variável auxiliar para a animação do objeto
 	byte animIndex;
+
+	/// Categorias de colisão às quais o objeto pertence, um bit por categoria. O padrão é 1
+	Uint32 category;
+
+	/// Categorias com as quais o objeto colide quando é movimentado como partícula. Obstáculos cuja categoria não tem nenhum bit em comum com essa máscara são ignorados. O padrão é colidir com todas
+	Uint32 collisionMask;
 } Object;
 
 /// Cria um objeto simples com posição e imagem. Sua caixa de colisão terá o mesmo tamanho da imagem
@@ -71,6 +78,13 @@ Object *newBlockSprite(Point pos, Image *spriteSheet, byte columns, byte lines);
 /// @return O objeto gerado
 Object *newSprite(Point pos, Point size, Point boundsPos, Image *spriteSheet, byte columns, byte lines);
 
+/// Define as categorias de colisão de um objeto, permitindo manter todos os corpos num único mundo ou lista (por exemplo, tiros inimigos que não colidem entre si nem com inimigos)
+///
+/// @param obj Objeto a ser alterado
+/// @param category Categorias às quais o objeto pertence
+/// @param collisionMask Categorias com as quais o objeto colide
+void setCollisionLayers(Object *obj, Uint32 category, Uint32 collisionMask);
+
 /// Retorna a caixa de colisão de um objeto
 ///
 /// @param obj Objeto cuja caixa de colisão deve ser retornada
@@ -149,11 +163,17 @@ void move(Object *obj, float xVar, float yVar);
 /// @param interval Intervalo em frames entre cada passo da animação (cada alteração de imagem) 
 void animate(Object *obj, byte *indices, byte size, byte interval);
 
-/// Desenha um objeto na tela
+/// Desenha um objeto na tela. Objetos totalmente fora da tela não são desenhados
 ///
 /// @param obj Objeto a ser desenhado
 void drawObject(Object *obj);
 
+/// Desenha vários objetos na tela, na ordem dada. Os objetos fora da tela são descartados por um único teste em lote (intersectsMask)
+///
+/// @param objects Vetor com os objetos a serem desenhados
+/// @param count Quantidade de objetos no vetor
+void drawObjects(Object **objects, int count);
+
 /// Libera a memória usada por um objeto
 ///
 /// @param obj Objeto a ser deletado
@@ -1,19 +1,69 @@
+#include <float.h>
 #include "particle.h"
 
+void findContact(Particle *part, float x, float y, float width, float height, Rectangle obsBounds, Object *obs);
+bool touchesEdge(float a, float b);
+void stopAtContacts(Particle *part, float *xVar, float *yVar);
+bool resolveCollision(Particle *part, float x, float y, float width, float height, float xVar, float yVar, Rectangle obsBounds, Object *obs);
+bool findTileContact(Rectangle tile, void *data);
+bool resolveTileCollision(Rectangle tile, void *data);
+bool findTileImpact(Rectangle tile, void *data);
+
+static inline bool ignoresObstacle(Particle *part, Object *obs)
+{
+	// Um único AND decide se a partícula colide com a categoria do obstáculo, antes de qualquer teste geométrico
+	return obs == part->obj || !(obs->category & part->obj->collisionMask);
+}
+
+typedef struct {
+	Particle *part;
+	Object *tile;
+	float x, y, width, height, xVar, yVar;
+	bool moving;
+} TileSweep;
+
+typedef struct {
+	Object *self, *tile;
+	float x, y, width, height, xVar, yVar;
+
+	// Impacto mais cedo encontrado até agora: fração do movimento, eixo (true para x), obstáculo e seus limites
+	float time;
+	bool xAxis;
+	Object *obs;
+	Rectangle obsBounds;
+} ImpactSearch;
+
+void findImpact(ImpactSearch *s, Rectangle obsBounds, Object *obs);
+
 Particle *newParticle(Object *obj, float maxSpeed, float mass)
 {
-	Particle *part = (Particle *)safeMalloc(sizeof(*part));
+	Particle *part = (Particle *)taggedMalloc(sizeof(*part), MEMORY_PARTICLE);
 	part->obj = obj;
 	part->speed = newPoint(0,0);
 	part->mass = mass;
 	part->maxSpeed = maxSpeed;
 	part->top = part->right = part->bottom = part->left = NULL;
+	part->sleeping = false;
 
 	return part;
 }
 
 void setSpeed(Particle *part, float xSpeed, float ySpeed)
 {
+	if (part->sleeping)
+	{
+		// Uma partícula dormindo continua parada enquanto a velocidade pedida for barrada pelos seus contatos
+		float epsilon = 0.0001f, x = xSpeed, y = ySpeed;
+		if ((x > 0 && part->right) || (x < 0 && part->left)) x = 0;
+		if ((y > 0 && part->bottom) || (y < 0 && part->top)) y = 0;
+		if (x > -epsilon && x < epsilon && y > -epsilon && y < epsilon)
+		{
+			part->speed = newPoint(0, 0);
+			return;
+		}
+		part->sleeping = false;
+	}
+
 	part->speed.x = xSpeed;
 	part->speed.y = ySpeed;
 
@@ -46,9 +96,6 @@ void *setObstacleAttributes(void *_obs, bool particles, float *obsX, float *obsY
 
 void moveParticle(Particle *part, List *obstacles, bool particles)
 {
-	int i;
-	float epsilon = 0.0001f;
-
 	if (obstacles)
 	{
 		float xVar = part->speed.x, yVar = part->speed.y,
@@ -61,112 +108,378 @@ void moveParticle(Particle *part, List *obstacles, bool particles)
 		for (n = obstacles->head->next; n != obstacles->tail; n = n->next)
 		{
 			obs = setObstacleAttributes(n->item, particles, &obsX, &obsY, &obsWidth, &obsHeight);
-			if (obs == part->obj) continue;
+			if (ignoresObstacle(part, obs)) continue;
+			findContact(part, x, y, width, height, newRectangle(obsX, obsY, obsWidth, obsHeight), obs);
+		}
 
-			if (x + width > obsX && obsX + obsWidth > x && obsY + obsHeight == y)
-				part->top = obs;
+		stopAtContacts(part, &xVar, &yVar);
 
-			if (y + height > obsY && obsY + obsHeight > y && x + width == obsX)
-				part->right = obs;
+		for (n = obstacles->head->next; n != obstacles->tail; n = n->next)
+		{
+			obs = setObstacleAttributes(n->item, particles, &obsX, &obsY, &obsWidth, &obsHeight);
+			if (ignoresObstacle(part, obs)) continue;
+			if (!resolveCollision(part, x, y, width, height, xVar, yVar, newRectangle(obsX, obsY, obsWidth, obsHeight), obs))
+				break;
+		}
+	}
+	move(part->obj, part->speed.x, part->speed.y);
+}
 
-			if (x + width > obsX && obsX + obsWidth > x && y + height == obsY)
-				part->bottom = obs;
+void moveParticleBatch(Particle *part, RectangleArray *bounds, Object **obstacles)
+{
+	float xVar = part->speed.x, yVar = part->speed.y,
+		x = getX(part->obj), y = getY(part->obj), width = getWidth(part->obj), height = getHeight(part->obj);
 
-			if (y + height > obsY && obsY + obsHeight > y && obsX + obsWidth == x)
-				part->left = obs;
+	// Só os obstáculos que interceptam a área varrida pelo movimento podem afetar a partícula
+	Rectangle area = getSweptArea(part);
+	Uint32 mask[(bounds->size + 31) / 32 + 1];
+	int words = (bounds->size + 31) / 32, w;
+	intersectsMask(area, bounds, mask);
+
+	part->top = part->right = part->bottom = part->left = NULL;
+	for (w = 0; w < words; w++)
+	{
+		Uint32 bits = mask[w];
+		for (; bits; bits &= bits - 1)
+		{
+			Object *obs = obstacles[w * 32 + __builtin_ctz(bits)];
+			if (!ignoresObstacle(part, obs)) findContact(part, x, y, width, height, getBounds(obs), obs);
+		}
+	}
+
+	stopAtContacts(part, &xVar, &yVar);
+
+	bool moving = true;
+	for (w = 0; w < words && moving; w++)
+	{
+		Uint32 bits = mask[w];
+		for (; bits && moving; bits &= bits - 1)
+		{
+			Object *obs = obstacles[w * 32 + __builtin_ctz(bits)];
+			if (!ignoresObstacle(part, obs)) moving = resolveCollision(part, x, y, width, height, xVar, yVar, getBounds(obs), obs);
 		}
+	}
+	move(part->obj, part->speed.x, part->speed.y);
+}
 
-		if (part->top && part->speed.y < epsilon) part->speed.y = yVar = 0;
-		if (part->right && part->speed.x > -epsilon) part->speed.x = xVar = 0;
-		if (part->bottom && part->speed.y > -epsilon) part->speed.y = yVar = 0;
-		if (part->left && part->speed.x < epsilon) part->speed.x = xVar = 0;
+void moveParticleTiles(Particle *part, TileMap *map, List *obstacles, bool particles)
+{
+	TileSweep s;
+	s.part = part;
+	s.tile = map->tile;
+	s.x = getX(part->obj), s.y = getY(part->obj), s.width = getWidth(part->obj), s.height = getHeight(part->obj);
+	s.xVar = part->speed.x, s.yVar = part->speed.y;
+	s.moving = true;
+	bool tiles = map->tile->category & part->obj->collisionMask;
+
+	// Apenas as células cobertas pela área varrida são visitadas, independentemente do tamanho da grade
+	Rectangle area = getSweptArea(part);
+	float obsX, obsY, obsWidth, obsHeight;
+	void *obs = NULL;
+	Node *n;
 
+	part->top = part->right = part->bottom = part->left = NULL;
+	if (tiles) forEachSolidTile(map, area, findTileContact, &s);
+	if (obstacles)
 		for (n = obstacles->head->next; n != obstacles->tail; n = n->next)
 		{
 			obs = setObstacleAttributes(n->item, particles, &obsX, &obsY, &obsWidth, &obsHeight);
-			if (obs == part->obj) continue;
-			Rectangle obsBounds = newRectangle(obsX, obsY, obsWidth, obsHeight);
+			if (ignoresObstacle(part, obs)) continue;
+			findContact(part, s.x, s.y, s.width, s.height, newRectangle(obsX, obsY, obsWidth, obsHeight), obs);
+		}
+
+	stopAtContacts(part, &s.xVar, &s.yVar);
+
+	if (tiles) forEachSolidTile(map, area, resolveTileCollision, &s);
+	if (obstacles)
+		for (n = obstacles->head->next; n != obstacles->tail && s.moving; n = n->next)
+		{
+			obs = setObstacleAttributes(n->item, particles, &obsX, &obsY, &obsWidth, &obsHeight);
+			if (ignoresObstacle(part, obs)) continue;
+			s.moving = resolveCollision(part, s.x, s.y, s.width, s.height, s.xVar, s.yVar, newRectangle(obsX, obsY, obsWidth, obsHeight), obs);
+		}
+
+	move(part->obj, part->speed.x, part->speed.y);
+}
+
+void moveParticleArray(Particle *part, Object **obstacles, int count, TileMap *map)
+{
+	findParticleContacts(part, obstacles, count, map);
+	resolveParticleMovement(part, obstacles, count, map);
+}
+
+void findParticleContacts(Particle *part, Object **obstacles, int count, TileMap *map)
+{
+	TileSweep s;
+	s.part = part;
+	if (map && !(map->tile->category & part->obj->collisionMask)) map = NULL;
+	s.tile = map ? map->tile : NULL;
+	s.x = getX(part->obj), s.y = getY(part->obj), s.width = getWidth(part->obj), s.height = getHeight(part->obj);
+
+	int i;
+	part->top = part->right = part->bottom = part->left = NULL;
+	if (map) forEachSolidTile(map, getSweptArea(part), findTileContact, &s);
+	for (i = 0; i < count; i++)
+		if (!ignoresObstacle(part, obstacles[i]))
+			findContact(part, s.x, s.y, s.width, s.height, getBounds(obstacles[i]), obstacles[i]);
+}
+
+void addParticleContacts(Particle *part, Object **obstacles, int count)
+{
+	float x = getX(part->obj), y = getY(part->obj), width = getWidth(part->obj), height = getHeight(part->obj);
+	int i;
+	for (i = 0; i < count; i++)
+		if (!ignoresObstacle(part, obstacles[i]))
+			findContact(part, x, y, width, height, getBounds(obstacles[i]), obstacles[i]);
+}
+
+void resolveParticleMovement(Particle *part, Object **obstacles, int count, TileMap *map)
+{
+	TileSweep s;
+	s.part = part;
+	if (map && !(map->tile->category & part->obj->collisionMask)) map = NULL;
+	s.tile = map ? map->tile : NULL;
+	s.x = getX(part->obj), s.y = getY(part->obj), s.width = getWidth(part->obj), s.height = getHeight(part->obj);
+	s.xVar = part->speed.x, s.yVar = part->speed.y;
+	s.moving = true;
+
+	Rectangle area = getSweptArea(part);
+	int i;
+
+	stopAtContacts(part, &s.xVar, &s.yVar);
+
+	if (map) forEachSolidTile(map, area, resolveTileCollision, &s);
+	for (i = 0; i < count && s.moving; i++)
+		if (!ignoresObstacle(part, obstacles[i]))
+			s.moving = resolveCollision(part, s.x, s.y, s.width, s.height, s.xVar, s.yVar, getBounds(obstacles[i]), obstacles[i]);
+
+	move(part->obj, part->speed.x, part->speed.y);
+}
+
+void moveParticleSwept(Particle *part, Object **obstacles, int count, TileMap *map)
+{
+	findParticleContacts(part, obstacles, count, map);
+	resolveSweptMovement(part, obstacles, count, map);
+}
+
+void resolveSweptMovement(Particle *part, Object **obstacles, int count, TileMap *map)
+{
+	ImpactSearch s;
+	s.self = part->obj;
+	if (map && !(map->tile->category & part->obj->collisionMask)) map = NULL;
+	s.tile = map ? map->tile : NULL;
+	s.x = getX(part->obj), s.y = getY(part->obj), s.width = getWidth(part->obj), s.height = getHeight(part->obj);
+	s.xVar = part->speed.x, s.yVar = part->speed.y;
+
+	stopAtContacts(part, &s.xVar, &s.yVar);
+
+	// Cada impacto zera a velocidade num eixo e a partícula desliza no outro pelo tempo restante, então bastam dois impactos
+	float epsilon = 0.0001f, remaining = 1;
+	int hits, i;
+	for (hits = 0; hits < 2; hits++)
+	{
+		s.xVar = part->speed.x * remaining, s.yVar = part->speed.y * remaining;
+		if (s.xVar > -epsilon && s.xVar < epsilon && s.yVar > -epsilon && s.yVar < epsilon) break;
+
+		s.time = 1;
+		s.obs = NULL;
+		if (map)
+		{
+			Rectangle area = newRectangle(s.x + (s.xVar < 0 ? s.xVar : 0) - 1, s.y + (s.yVar < 0 ? s.yVar : 0) - 1,
+				s.width + fabs(s.xVar) + 2, s.height + fabs(s.yVar) + 2);
+			forEachSolidTile(map, area, findTileImpact, &s);
+		}
+		for (i = 0; i < count; i++)
+			if (!ignoresObstacle(part, obstacles[i]))
+				findImpact(&s, getBounds(obstacles[i]), obstacles[i]);
+
+		if (s.obs == NULL)
+		{
+			s.x += s.xVar, s.y += s.yVar;
+			break;
+		}
+
+		// A partícula é encostada exatamente na borda atingida, e avança no outro eixo até o instante do impacto
+		Rectangle b = s.obsBounds;
+		if (s.xAxis)
+		{
+			if (s.xVar > 0) s.x = b.position.x - s.width, part->right = s.obs;
+			else s.x = b.position.x + b.size.x, part->left = s.obs;
+			s.y += s.yVar * s.time;
+			part->speed.x = 0;
+		}
+		else
+		{
+			if (s.yVar > 0) s.y = b.position.y - s.height, part->bottom = s.obs;
+			else s.y = b.position.y + b.size.y, part->top = s.obs;
+			s.x += s.xVar * s.time;
+			part->speed.y = 0;
+		}
+		remaining *= 1 - s.time;
+	}
+
+	setPosition(part->obj, newPoint(s.x, s.y));
+}
+
+Rectangle getSweptArea(Particle *part)
+{
+	// Área percorrida pelo movimento, ampliada em uma unidade para incluir os obstáculos que apenas encostam na partícula
+	float xVar = part->speed.x, yVar = part->speed.y;
+	return newRectangle(getX(part->obj) + (xVar < 0 ? xVar : 0) - 1, getY(part->obj) + (yVar < 0 ? yVar : 0) - 1,
+		getWidth(part->obj) + fabs(xVar) + 2, getHeight(part->obj) + fabs(yVar) + 2);
+}
+
+bool findTileContact(Rectangle tile, void *data)
+{
+	TileSweep *s = (TileSweep *)data;
+	findContact(s->part, s->x, s->y, s->width, s->height, tile, s->tile);
+	return true;
+}
+
+bool resolveTileCollision(Rectangle tile, void *data)
+{
+	TileSweep *s = (TileSweep *)data;
+	s->moving = resolveCollision(s->part, s->x, s->y, s->width, s->height, s->xVar, s->yVar, tile, s->tile);
+	return s->moving;
+}
+
+bool findTileImpact(Rectangle tile, void *data)
+{
+	ImpactSearch *s = (ImpactSearch *)data;
+	findImpact(s, tile, s->tile);
+	return true;
+}
+
+void findImpact(ImpactSearch *s, Rectangle obsBounds, Object *obs)
+{
+	float obsX = obsBounds.position.x, obsY = obsBounds.position.y, obsWidth = obsBounds.size.x, obsHeight = obsBounds.size.y,
+		entryX, exitX, entryY, exitY;
+
+	// Intervalo de tempo (em frações do movimento) em que os retângulos se sobrepõem em cada eixo
+	if (s->xVar > 0) entryX = (obsX - (s->x + s->width)) / s->xVar, exitX = (obsX + obsWidth - s->x) / s->xVar;
+	else if (s->xVar < 0) entryX = (obsX + obsWidth - s->x) / s->xVar, exitX = (obsX - (s->x + s->width)) / s->xVar;
+	else if (s->x + s->width > obsX && obsX + obsWidth > s->x) entryX = -INFINITY, exitX = INFINITY;
+	else return;
+
+	if (s->yVar > 0) entryY = (obsY - (s->y + s->height)) / s->yVar, exitY = (obsY + obsHeight - s->y) / s->yVar;
+	else if (s->yVar < 0) entryY = (obsY + obsHeight - s->y) / s->yVar, exitY = (obsY - (s->y + s->height)) / s->yVar;
+	else if (s->y + s->height > obsY && obsY + obsHeight > s->y) entryY = -INFINITY, exitY = INFINITY;
+	else return;
+
+	// Obstáculos já sobrepostos à partícula (entrada antes do início) são ignorados, como em moveParticle
+	float entry = entryX > entryY ? entryX : entryY, exit = exitX < exitY ? exitX : exitY;
+	if (entry >= exit || entry < 0 || entry >= s->time) return;
+
+	s->time = entry;
+	s->xAxis = entryX > entryY;
+	s->obs = obs;
+	s->obsBounds = obsBounds;
+}
+
+void findContact(Particle *part, float x, float y, float width, float height, Rectangle obsBounds, Object *obs)
+{
+	// As bordas são comparadas com uma pequena tolerância, para que erros de arredondamento acumulados não desfaçam um contato
+	float obsX = obsBounds.position.x, obsY = obsBounds.position.y, obsWidth = obsBounds.size.x, obsHeight = obsBounds.size.y;
 
-			if (part->speed.x >-epsilon && part->speed.x < epsilon ) // X NULO
+	if (x + width > obsX && obsX + obsWidth > x && touchesEdge(obsY + obsHeight, y))
+		part->top = obs;
+
+	if (y + height > obsY && obsY + obsHeight > y && touchesEdge(x + width, obsX))
+		part->right = obs;
+
+	if (x + width > obsX && obsX + obsWidth > x && touchesEdge(y + height, obsY))
+		part->bottom = obs;
+
+	if (y + height > obsY && obsY + obsHeight > y && touchesEdge(obsX + obsWidth, x))
+		part->left = obs;
+}
+
+bool touchesEdge(float a, float b)
+{
+	// A tolerância absoluta fica abaixo da precisão de um float longe da origem (a partir de uns 8000 pixels), então cresce com a coordenada
+	float tolerance = fmaxf(0.001f, 4 * FLT_EPSILON * fmaxf(fabsf(a), fabsf(b)));
+	return fabsf(a - b) <= tolerance;
+}
+
+void stopAtContacts(Particle *part, float *xVar, float *yVar)
+{
+	float epsilon = 0.0001f;
+
+	if (part->top && part->speed.y < epsilon) part->speed.y = *yVar = 0;
+	if (part->right && part->speed.x > -epsilon) part->speed.x = *xVar = 0;
+	if (part->bottom && part->speed.y > -epsilon) part->speed.y = *yVar = 0;
+	if (part->left && part->speed.x < epsilon) part->speed.x = *xVar = 0;
+}
+
+bool resolveCollision(Particle *part, float x, float y, float width, float height, float xVar, float yVar, Rectangle obsBounds, Object *obs)
+{
+	float epsilon = 0.0001f,
+		obsX = obsBounds.position.x, obsY = obsBounds.position.y, obsWidth = obsBounds.size.x, obsHeight = obsBounds.size.y;
+
+	if (part->speed.x >-epsilon && part->speed.x < epsilon ) // X NULO
+	{
+		if (part->speed.y >-epsilon && part->speed.y < epsilon ) // X NULO E Y NULO
+			return false;
+		else if (part->speed.y > epsilon) // X NULO E Y POSITIVO
+		{
+			Rectangle moveRec = newRectangle(x, y, width, height + yVar);
+
+			if (intersects(obsBounds, moveRec) && y + height <= obsY)
 			{
-				if (part->speed.y >-epsilon && part->speed.y < epsilon ) // X NULO E Y NULO
-					break;
-				else if (part->speed.y > epsilon) // X NULO E Y POSITIVO
-				{
-					Rectangle moveRec = newRectangle(x, y, width, height + yVar);
+				// vai limitar Y
+				part->speed.y = 0;
+				setY(part->obj, obsY - height);
+				part->bottom = obs;
+			}
+		}
+		else // X NULO E Y NEGATIVO
+		{
+			Rectangle moveRec = newRectangle(x, y + yVar, width, height - yVar);
 
-					if (intersects(obsBounds, moveRec) && y + height <= obsY)
-					{
-						// vai limitar Y
-						part->speed.y = 0;
-						setY(part->obj, obsY - height);
-						part->bottom = obs;
-					}
-				}
-				else // X NULO E Y NEGATIVO
-				{
-					Rectangle moveRec = newRectangle(x, y + yVar, width, height - yVar);
+			if (intersects(obsBounds, moveRec) && obsY + obsHeight <= y)
+			{
+				// vai limitar Y
+				part->speed.y = 0;
+				setY(part->obj, obsY + obsHeight);
+				part->top = obs;
+			}
+		}
+	}
+	else if (part->speed.x > epsilon) // X POSITIVO
+	{
+		if (part->speed.y >-epsilon && part->speed.y < epsilon ) // X POSITIVO E Y NULO
+		{
+			Rectangle moveRec = newRectangle(x, y, width + xVar, height);
 
-					if (intersects(obsBounds, moveRec) && obsY + obsHeight <= y)
-					{
-						// vai limitar Y
-						part->speed.y = 0;
-						setY(part->obj, obsY + obsHeight);
-						part->top = obs;
-					}
-				}
+			if (intersects(obsBounds, moveRec) && x + width <= obsX)
+			{
+				// vai limitar X
+				part->speed.x = 0;
+				setX(part->obj, obsX - width);
+				part->right = obs;
 			}
-			else if (part->speed.x > epsilon) // X POSITIVO
+		}
+		else if (part->speed.y > epsilon) // X POSITIVO E Y POSITIVO
+		{
+			Rectangle moveRec = newRectangle(x, y, width + xVar, height + yVar);
+
+			if (intersects(obsBounds, moveRec))
 			{
-				if (part->speed.y >-epsilon && part->speed.y < epsilon ) // X POSITIVO E Y NULO
+				if (obsX >= x + width)
 				{
-					Rectangle moveRec = newRectangle(x, y, width + xVar, height);
-
-					if (intersects(obsBounds, moveRec) && x + width <= obsX)
+					// possivel limitar X
+					if (obsY >= y + height)
 					{
-						// vai limitar X
-						part->speed.x = 0;
-						setX(part->obj, obsX - width);
-						part->right = obs;
-					}
-				}
-				else if (part->speed.y > epsilon) // X POSITIVO E Y POSITIVO
-				{
-					Rectangle moveRec = newRectangle(x, y, width + xVar, height + yVar);
+						// possivel limitar Y também, verificar qual limita
+						float timeX = (obsX - (x + width)) / xVar;
+						float timeY = (obsY - (y + height)) / yVar;
 
-					if (intersects(obsBounds, moveRec))
-					{
-						if (obsX >= x + width)
+						if (timeX >= timeY)
 						{
-							// possivel limitar X
-							if (obsY >= y + height)
-							{
-								// possivel limitar Y também, verificar qual limita
-								float timeX = (obsX - x + width) / xVar;
-								float timeY = (obsY - y + height) / yVar;
-
-								if (timeX >= timeY)
-								{
-									// vai limitar X
-									part->speed.x = 0;
-									setX(part->obj, obsX - width);
-									part->right = obs;
-								}
-								else if (y + height <= obsY)
-								{
-									// vai limitar Y
-									part->speed.y = 0;
-									setY(part->obj, obsY - height);
-									part->bottom = obs;
-								}
-							}
-							else
-							{
-								// vai limitar X
-								part->speed.x = 0;
-								setX(part->obj, obsX - width);
-								part->right = obs;
-							}
+							// vai limitar X
+							part->speed.x = 0;
+							setX(part->obj, obsX - width);
+							part->right = obs;
 						}
 						else if (y + height <= obsY)
 						{
@@ -176,46 +489,46 @@ void moveParticle(Particle *part, List *obstacles, bool particles)
 							part->bottom = obs;
 						}
 					}
+					else
+					{
+						// vai limitar X
+						part->speed.x = 0;
+						setX(part->obj, obsX - width);
+						part->right = obs;
+					}
 				}
-				else // X POSITIVO E Y NEGATIVO
+				else if (y + height <= obsY)
 				{
-					Rectangle moveRec = newRectangle(x, y + yVar, width + xVar, height - yVar);
+					// vai limitar Y
+					part->speed.y = 0;
+					setY(part->obj, obsY - height);
+					part->bottom = obs;
+				}
+			}
+		}
+		else // X POSITIVO E Y NEGATIVO
+		{
+			Rectangle moveRec = newRectangle(x, y + yVar, width + xVar, height - yVar);
 
-					if (intersects(obsBounds, moveRec))
+			if (intersects(obsBounds, moveRec))
+			{
+				if (obsX >= x + width)
+				{
+					// possivel limitar X
+					if (obsY + obsHeight <= y)
 					{
-						if (obsX >= x + width)
+						// possivel limitar Y também, verificar qual limita
+						float timeX = (obsX - (x + width)) / xVar;
+						float timeY = (obsY + obsHeight - y) / yVar;
+
+						if (timeX >= timeY)
 						{
-							// possivel limitar X
-							if (obsY + obsHeight <= y)
-							{
-								// possivel limitar Y também, verificar qual limita
-								float timeX = (obsX - x + width) / xVar;
-								float timeY = (obsY + obsHeight - y) / yVar;
-
-								if (timeX >= timeY)
-								{
-									// vai limitar X
-									part->speed.x = 0;
-									setX(part->obj, obsX - width);
-									part->right = obs;
-								}
-								else
-								{
-									// vai limitar Y
-									part->speed.y = 0;
-									setY(part->obj, obsY + obsHeight);
-									part->top = obs;
-								}
-							}
-							else
-							{
-								// vai limitar X
-								part->speed.x = 0;
-								setX(part->obj, obsX - width);
-								part->right = obs;
-							}
+							// vai limitar X
+							part->speed.x = 0;
+							setX(part->obj, obsX - width);
+							part->right = obs;
 						}
-						else if (obsY + obsHeight <= y)
+						else
 						{
 							// vai limitar Y
 							part->speed.y = 0;
@@ -223,59 +536,59 @@ void moveParticle(Particle *part, List *obstacles, bool particles)
 							part->top = obs;
 						}
 					}
-				}
-			}
-			else // X NEGATIVO
-			{
-				if (part->speed.y >-epsilon && part->speed.y < epsilon ) // X NEGATIVO E Y NULO
-				{
-					Rectangle moveRec = newRectangle(x + xVar, y, width - xVar, height);
-
-					if (intersects(obsBounds, moveRec) && obsX + obsWidth <= x)
+					else
 					{
 						// vai limitar X
 						part->speed.x = 0;
-						setX(part->obj, obsX + obsWidth);
-						part->left = obs;
+						setX(part->obj, obsX - width);
+						part->right = obs;
 					}
 				}
-				else if (part->speed.y > epsilon) // X NEGATIVO E Y POSITIVO
+				else if (obsY + obsHeight <= y)
 				{
-					Rectangle moveRec = newRectangle(x + xVar, y, width - xVar, height + yVar);
+					// vai limitar Y
+					part->speed.y = 0;
+					setY(part->obj, obsY + obsHeight);
+					part->top = obs;
+				}
+			}
+		}
+	}
+	else // X NEGATIVO
+	{
+		if (part->speed.y >-epsilon && part->speed.y < epsilon ) // X NEGATIVO E Y NULO
+		{
+			Rectangle moveRec = newRectangle(x + xVar, y, width - xVar, height);
+
+			if (intersects(obsBounds, moveRec) && obsX + obsWidth <= x)
+			{
+				// vai limitar X
+				part->speed.x = 0;
+				setX(part->obj, obsX + obsWidth);
+				part->left = obs;
+			}
+		}
+		else if (part->speed.y > epsilon) // X NEGATIVO E Y POSITIVO
+		{
+			Rectangle moveRec = newRectangle(x + xVar, y, width - xVar, height + yVar);
 
-					if (intersects(obsBounds, moveRec))
+			if (intersects(obsBounds, moveRec))
+			{
+				if (obsX + obsWidth <= x)
+				{
+					// possivel limitar X
+					if (obsY >= y + height)
 					{
-						if (obsX + obsWidth <= x)
+						// possivel limitar Y também, verificar qual limita
+						float timeX = (obsX + obsWidth - x) / xVar;
+						float timeY = (obsY - (y + height)) / yVar;
+
+						if (timeX >= timeY)
 						{
-							// possivel limitar X
-							if (obsY >= y + height)
-							{
-								// possivel limitar Y também, verificar qual limita
-								float timeX = (obsX + obsWidth - x) / xVar;
-								float timeY = (obsY - y + height) / yVar;
-
-								if (timeX >= timeY)
-								{
-									// vai limitar X
-									part->speed.x = 0;
-									setX(part->obj, obsX + obsWidth);
-									part->left = obs;
-								}
-								else if (y + height <= obsY)
-								{
-									// vai limitar Y
-									part->speed.y = 0;
-									setY(part->obj, obsY - height);
-									part->bottom = obs;
-								}
-							}
-							else
-							{
-								// vai limitar X
-								part->speed.x = 0;
-								setX(part->obj, obsX + obsWidth);
-								part->left = obs;
-							}
+							// vai limitar X
+							part->speed.x = 0;
+							setX(part->obj, obsX + obsWidth);
+							part->left = obs;
 						}
 						else if (y + height <= obsY)
 						{
@@ -285,46 +598,46 @@ void moveParticle(Particle *part, List *obstacles, bool particles)
 							part->bottom = obs;
 						}
 					}
+					else
+					{
+						// vai limitar X
+						part->speed.x = 0;
+						setX(part->obj, obsX + obsWidth);
+						part->left = obs;
+					}
 				}
-				else // X NEGATIVO E Y NEGATIVO
+				else if (y + height <= obsY)
 				{
-					Rectangle moveRec = newRectangle(x + xVar, y + yVar, width - xVar, height - yVar);
+					// vai limitar Y
+					part->speed.y = 0;
+					setY(part->obj, obsY - height);
+					part->bottom = obs;
+				}
+			}
+		}
+		else // X NEGATIVO E Y NEGATIVO
+		{
+			Rectangle moveRec = newRectangle(x + xVar, y + yVar, width - xVar, height - yVar);
 
-					if (intersects(obsBounds, moveRec))
+			if (intersects(obsBounds, moveRec))
+			{
+				if (obsX + obsWidth <= x)
+				{
+					// possivel limitar X
+					if (obsY + obsHeight <= y)
 					{
-						if (obsX + obsWidth <= x)
+						// possivel limitar Y também, verificar qual limita
+						float timeX = (obsX + obsWidth - x) / xVar;
+						float timeY = (obsY + obsHeight - y) / yVar;
+
+						if (timeX >= timeY)
 						{
-							// possivel limitar X
-							if (obsY + obsHeight <= y)
-							{
-								// possivel limitar Y também, verificar qual limita
-								float timeX = (obsX + obsWidth - x) / xVar;
-								float timeY = (obsY + obsHeight - y) / yVar;
-
-								if (timeX >= timeY)
-								{
-									// vai limitar X
-									part->speed.x = 0;
-									setX(part->obj, obsX + obsWidth);
-									part->left = obs;
-								}
-								else
-								{
-									// vai limitar Y
-									part->speed.y = 0;
-									setY(part->obj, obsY + obsHeight);
-									part->top = obs;
-								}
-							}
-							else
-							{
-								// vai limitar X
-								part->speed.x = 0;
-								setX(part->obj, obsX + obsWidth);
-								part->left = obs;
-							}
+							// vai limitar X
+							part->speed.x = 0;
+							setX(part->obj, obsX + obsWidth);
+							part->left = obs;
 						}
-						else if (obsY + obsHeight <= y)
+						else
 						{
 							// vai limitar Y
 							part->speed.y = 0;
@@ -332,16 +645,35 @@ void moveParticle(Particle *part, List *obstacles, bool particles)
 							part->top = obs;
 						}
 					}
+					else
+					{
+						// vai limitar X
+						part->speed.x = 0;
+						setX(part->obj, obsX + obsWidth);
+						part->left = obs;
+					}
+				}
+				else if (obsY + obsHeight <= y)
+				{
+					// vai limitar Y
+					part->speed.y = 0;
+					setY(part->obj, obsY + obsHeight);
+					part->top = obs;
 				}
 			}
 		}
 	}
-	move(part->obj, part->speed.x, part->speed.y);
+	return true;
+}
+
+void wakeParticle(Particle *part)
+{
+	part->sleeping = false;
 }
 
 void freeParticle(Particle *part)
 {
 	freeObject(part->obj);
-	free(part);
+	taggedFree(part);
 }
 
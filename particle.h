@@ -4,6 +4,8 @@
 #define MINI_PARTICLE_H
 
 #include "object.h"
+#include "rectarray.h"
+#include "tilemap.h"
 #include <math.h>
 
 /// Estrutura que representa um objeto com propriedades físicas, que pode ser usado para movimentação baseada em forças e para tratar colisões
@@ -31,6 +33,9 @@ typedef struct{
 
 	/// Objeto com o qual este está colidindo à esquerda (se não houver colisão à esquerda, será nulo)
 	Object *left;
+
+	/// Verdadeiro enquanto a partícula estiver dormindo num mundo físico (ver World), parada e sem ser movimentada por stepPhysics
+	bool sleeping;
 } Particle;
 
 /// Cria uma nova partícula (objeto com propriedades físicas)
@@ -41,7 +46,7 @@ typedef struct{
 /// @return A partícula gerada
 Particle *newParticle(Object *obj, float maxSpeed, float mass);
 
-/// Define a velocidade de uma partícula
+/// Define a velocidade de uma partícula. Se a partícula estiver dormindo, ela só é acordada se a nova velocidade não for barrada pelos contatos atuais (por exemplo, a gravidade sobre uma partícula apoiada no chão não a acorda)
 ///
 /// @param part Partícula cuja velocidade deve ser alterada
 /// @param xSpeed Nova componente x da velocidade
@@ -62,6 +67,79 @@ void setForces(Particle *part, float xForces, float yForces);
 /// @param particles Deve ser verdadeiro se os itens da lista são do tipo Particle, falso para itens do tipo Object
 void moveParticle(Particle *part, List *obstacles, bool particles);
 
+/// Movimenta uma partícula como moveParticle, mas usando obstáculos guardados num vetor compacto de retângulos. Apenas os obstáculos que interceptam a área percorrida pela partícula, encontrados por um teste em lote (intersectsMask), passam pelo tratamento de colisão, na mesma ordem em que estão no vetor
+///
+/// @param part Partícula a ser movimentada
+/// @param bounds Caixas de colisão dos obstáculos. A posição i deve conter os limites atuais de obstacles[i]
+/// @param obstacles Vetor com os obstáculos, com bounds->size posições
+void moveParticleBatch(Particle *part, RectangleArray *bounds, Object **obstacles);
+
+/// Movimenta uma partícula como moveParticle, tratando também a colisão com as células sólidas de uma grade de colisão. Apenas as células cobertas pelo movimento são consideradas, e as colisões com elas preenchem top, right, bottom e left com o objeto map->tile. As células são tratadas antes dos itens da lista 'obstacles'
+///
+/// @param part Partícula a ser movimentada
+/// @param map Grade de colisão com a geometria fixa da fase
+/// @param obstacles Lista de obstáculos adicionais a serem considerados. Pode ser nula
+/// @param particles Deve ser verdadeiro se os itens da lista são do tipo Particle, falso para itens do tipo Object
+void moveParticleTiles(Particle *part, TileMap *map, List *obstacles, bool particles);
+
+/// Movimenta uma partícula como moveParticle, considerando os obstáculos de um vetor, na ordem dada, e opcionalmente uma grade de colisão (tratada antes do vetor, como em moveParticleTiles)
+///
+/// @param part Partícula a ser movimentada
+/// @param obstacles Vetor com os objetos a serem considerados para tratamento de colisão
+/// @param count Quantidade de objetos no vetor
+/// @param map Grade de colisão. Pode ser nula
+void moveParticleArray(Particle *part, Object **obstacles, int count, TileMap *map);
+
+/// Primeira etapa de moveParticleArray: preenche top, right, bottom e left com os obstáculos que estão em contato com a partícula, sem movimentá-la. Não altera nenhum outro dado, e portanto pode ser executada em paralelo para partículas diferentes
+///
+/// @param part Partícula a ser considerada
+/// @param obstacles Vetor com os objetos a serem considerados
+/// @param count Quantidade de objetos no vetor
+/// @param map Grade de colisão. Pode ser nula
+void findParticleContacts(Particle *part, Object **obstacles, int count, TileMap *map);
+
+/// Acrescenta aos contatos atuais de uma partícula os obstáculos de um vetor que estão encostados nela, sem apagar os contatos já existentes. Um obstáculo encontrado substitui o contato anterior do mesmo lado
+///
+/// @param part Partícula a ser considerada
+/// @param obstacles Vetor com os objetos a serem considerados
+/// @param count Quantidade de objetos no vetor
+void addParticleContacts(Particle *part, Object **obstacles, int count);
+
+/// Segunda etapa de moveParticleArray: usa os contatos encontrados por findParticleContacts para limitar a velocidade, trata as colisões e movimenta a partícula
+///
+/// @param part Partícula a ser movimentada
+/// @param obstacles Vetor com os objetos a serem considerados para tratamento de colisão
+/// @param count Quantidade de objetos no vetor
+/// @param map Grade de colisão. Pode ser nula
+void resolveParticleMovement(Particle *part, Object **obstacles, int count, TileMap *map);
+
+/// Movimenta uma partícula com detecção contínua de colisão: encontra, entre todos os obstáculos do vetor e as células sólidas da grade, o primeiro que a partícula atinge (o menor tempo de impacto), encosta a partícula nele e a faz deslizar no outro eixo pelo tempo restante. Ao contrário de moveParticle, o resultado não depende da ordem dos obstáculos, e partículas rápidas não atravessam obstáculos finos, dispensando a divisão do movimento em passos menores
+///
+/// @param part Partícula a ser movimentada
+/// @param obstacles Vetor com os objetos a serem considerados para tratamento de colisão
+/// @param count Quantidade de objetos no vetor
+/// @param map Grade de colisão. Pode ser nula
+void moveParticleSwept(Particle *part, Object **obstacles, int count, TileMap *map);
+
+/// Segunda etapa de moveParticleSwept, equivalente a resolveParticleMovement: usa os contatos encontrados por findParticleContacts e movimenta a partícula até o primeiro impacto, deslizando em seguida
+///
+/// @param part Partícula a ser movimentada
+/// @param obstacles Vetor com os objetos a serem considerados para tratamento de colisão
+/// @param count Quantidade de objetos no vetor
+/// @param map Grade de colisão. Pode ser nula
+void resolveSweptMovement(Particle *part, Object **obstacles, int count, TileMap *map);
+
+/// Retorna a área que uma partícula pode percorrer ou tocar no próximo movimento, com sua velocidade atual. Qualquer obstáculo que afete o movimento intercepta essa área
+///
+/// @param part Partícula a ser considerada
+/// @return Retângulo que cobre a partícula antes e depois do movimento, ampliado em uma unidade em cada direção
+Rectangle getSweptArea(Particle *part);
+
+/// Acorda uma partícula que está dormindo num mundo físico, junto com as partículas em contato com ela. Deve ser usada quando algo que stepPhysics não percebe afeta a partícula, como o movimento de um obstáculo sobre o qual ela está apoiada
+///
+/// @param part Partícula a ser acordada
+void wakeParticle(Particle *part);
+
 /// Libera a memória usada por uma partícula
 ///
 /// @param part Partícula a ser deletada
@@ -0,0 +1,154 @@
+#include <stddef.h>
+#include "pool.h"
+
+typedef struct {
+	PoolSlot slot;
+	Object obj;
+} ObjectSlot;
+
+typedef struct {
+	PoolSlot slot;
+	Particle part;
+	Object obj;
+} ParticleSlot;
+
+Pool *newPool(int capacity, bool growable, bool particles);
+void growPool(Pool *pool, int count);
+PoolSlot *takeSlot(Pool *pool, void *item);
+void releaseSlot(Pool *pool, PoolSlot *slot);
+
+Pool *newObjectPool(Object *prototype, int capacity, bool growable)
+{
+	Pool *pool = newPool(capacity, growable, false);
+	pool->objPrototype = *prototype;
+	return pool;
+}
+
+Pool *newParticlePool(Particle *prototype, int capacity, bool growable)
+{
+	Pool *pool = newPool(capacity, growable, true);
+	pool->partPrototype = *prototype;
+	pool->objPrototype = *(prototype->obj);
+	return pool;
+}
+
+Object *spawnObject(Pool *pool, Point pos)
+{
+	if (pool->freeSlots == NULL)
+	{
+		if (!pool->growable) return NULL;
+		growPool(pool, pool->capacity);
+	}
+	ObjectSlot *s = (ObjectSlot *)pool->freeSlots;
+	s->obj = pool->objPrototype;
+	setPosition(&s->obj, pos);
+	takeSlot(pool, &s->obj);
+	return &s->obj;
+}
+
+Particle *spawnParticle(Pool *pool, Point pos)
+{
+	if (pool->freeSlots == NULL)
+	{
+		if (!pool->growable) return NULL;
+		growPool(pool, pool->capacity);
+	}
+	ParticleSlot *s = (ParticleSlot *)pool->freeSlots;
+	s->obj = pool->objPrototype;
+	s->part = pool->partPrototype;
+	s->part.obj = &s->obj;
+	setPosition(&s->obj, pos);
+	takeSlot(pool, &s->part);
+	return &s->part;
+}
+
+void despawnObject(Pool *pool, Object *obj)
+{
+	releaseSlot(pool, (PoolSlot *)((Uint8 *)obj - offsetof(ObjectSlot, obj)));
+}
+
+void despawnParticle(Pool *pool, Particle *part)
+{
+	releaseSlot(pool, (PoolSlot *)((Uint8 *)part - offsetof(ParticleSlot, part)));
+}
+
+void clearPool(Pool *pool)
+{
+	while (pool->size > 0)
+	{
+		if (pool->particles) despawnParticle(pool, (Particle *)pool->items[pool->size - 1]);
+		else despawnObject(pool, (Object *)pool->items[pool->size - 1]);
+	}
+}
+
+void freePool(Pool *pool)
+{
+	freeList(pool->blocks, taggedFree);
+	taggedFree(pool->items);
+	taggedFree(pool);
+}
+
+Pool *newPool(int capacity, bool growable, bool particles)
+{
+	Pool *pool = (Pool *)taggedMalloc(sizeof(*pool), particles ? MEMORY_PARTICLE : MEMORY_OBJECT);
+	pool->items = NULL;
+	pool->size = 0;
+	pool->capacity = 0;
+	pool->growable = growable;
+	pool->particles = particles;
+	pool->freeSlots = NULL;
+	pool->blocks = newList();
+	pool->slotSize = particles ? sizeof(ParticleSlot) : sizeof(ObjectSlot);
+	growPool(pool, capacity > 0 ? capacity : 1);
+	return pool;
+}
+
+void growPool(Pool *pool, int count)
+{
+	MemoryTag tag = pool->particles ? MEMORY_PARTICLE : MEMORY_OBJECT;
+	Uint8 *block = (Uint8 *)taggedMalloc(count * pool->slotSize, tag);
+	addItem(pool->blocks, block);
+
+	// Os espaços novos são encadeados na ordem do bloco, para que os primeiros itens obtidos fiquem contíguos na memória
+	int i;
+	for (i = count - 1; i >= 0; i--)
+	{
+		PoolSlot *s = (PoolSlot *)(block + i * pool->slotSize);
+		s->index = -1;
+		s->nextFree = pool->freeSlots;
+		pool->freeSlots = s;
+	}
+
+	void **items = (void **)taggedMalloc((pool->capacity + count) * sizeof(void *), tag);
+	if (pool->items)
+	{
+		memcpy(items, pool->items, pool->size * sizeof(void *));
+		taggedFree(pool->items);
+	}
+	pool->items = items;
+	pool->capacity += count;
+}
+
+PoolSlot *takeSlot(Pool *pool, void *item)
+{
+	PoolSlot *s = pool->freeSlots;
+	pool->freeSlots = s->nextFree;
+	s->index = pool->size;
+	pool->items[pool->size++] = item;
+	return s;
+}
+
+void releaseSlot(Pool *pool, PoolSlot *slot)
+{
+	if (slot->index < 0) return;
+
+	// O último item ativo ocupa a posição do item devolvido
+	void *last = pool->items[--pool->size];
+	PoolSlot *lastSlot = (PoolSlot *)((Uint8 *)last - (pool->particles ? offsetof(ParticleSlot, part) : offsetof(ObjectSlot, obj)));
+	pool->items[slot->index] = last;
+	lastSlot->index = slot->index;
+
+	slot->index = -1;
+	slot->nextFree = pool->freeSlots;
+	pool->freeSlots = slot;
+}
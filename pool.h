@@ -0,0 +1,102 @@
+/** @file */
+
+#ifndef MINI_POOL_H
+#define MINI_POOL_H
+
+#include "particle.h"
+
+/// Espaço de um pool. Cada espaço guarda um objeto (ou uma partícula e seu objeto) logo após esse cabeçalho
+typedef struct PoolSlot {
+	/// Próximo espaço livre (válido apenas enquanto este espaço estiver livre)
+	struct PoolSlot *nextFree;
+
+	/// Posição do item no vetor 'items' do pool, ou -1 se o espaço estiver livre
+	int index;
+} PoolSlot;
+
+/// Conjunto pré-alocado de objetos (Object) ou partículas (Particle) idênticos, para criação e destruição em tempo constante e sem alocações. Útil para tiros, faíscas, itens, etc.
+typedef struct {
+	/// Itens ativos (Object * ou Particle *, conforme o tipo do pool), em posições contíguas. Para percorrer os itens ativos, basta iterar de 0 a 'size' - 1
+	void **items;
+
+	/// Total de itens ativos
+	int size;
+
+	/// Total de espaços alocados
+	int capacity;
+
+	/// Determina se a capacidade pode crescer quando todos os espaços estiverem em uso
+	bool growable;
+
+	/// Verdadeiro se o pool contém partículas, falso se contém objetos
+	bool particles;
+
+	/// Lista de espaços livres
+	PoolSlot *freeSlots;
+
+	/// Blocos de memória onde estão os espaços
+	List *blocks;
+
+	/// Tamanho em bytes de cada espaço
+	size_t slotSize;
+
+	/// Objeto modelo, copiado para cada item criado
+	Object objPrototype;
+
+	/// Partícula modelo, copiada para cada item criado (usada apenas em pools de partículas)
+	Particle partPrototype;
+} Pool;
+
+/// Cria um pool de objetos. Os objetos criados pelo pool compartilham a imagem e a sprite sheet do modelo, que deve continuar existindo enquanto o pool for usado
+///
+/// @param prototype Objeto modelo. Cada objeto criado será uma cópia dele
+/// @param capacity Quantidade de objetos pré-alocados
+/// @param growable Verdadeiro para permitir que o pool cresça quando estiver cheio, falso para manter a capacidade fixa
+/// @return O pool gerado
+Pool *newObjectPool(Object *prototype, int capacity, bool growable);
+
+/// Cria um pool de partículas. As partículas criadas pelo pool compartilham a imagem e a sprite sheet do modelo, que deve continuar existindo enquanto o pool for usado
+///
+/// @param prototype Partícula modelo. Cada partícula criada será uma cópia dela (e de seu objeto)
+/// @param capacity Quantidade de partículas pré-alocadas
+/// @param growable Verdadeiro para permitir que o pool cresça quando estiver cheio, falso para manter a capacidade fixa
+/// @return O pool gerado
+Pool *newParticlePool(Particle *prototype, int capacity, bool growable);
+
+/// Obtém um objeto de um pool de objetos, já inicializado como cópia do modelo
+///
+/// @param pool Pool de objetos
+/// @param pos Posição do objeto
+/// @return O objeto obtido, ou nulo se o pool estiver cheio e não puder crescer
+Object *spawnObject(Pool *pool, Point pos);
+
+/// Obtém uma partícula de um pool de partículas, já inicializada como cópia do modelo
+///
+/// @param pool Pool de partículas
+/// @param pos Posição da partícula
+/// @return A partícula obtida, ou nula se o pool estiver cheio e não puder crescer
+Particle *spawnParticle(Pool *pool, Point pos);
+
+/// Devolve um objeto ao seu pool. O último item ativo passa a ocupar a posição do objeto devolvido em 'items', portanto ao devolver itens durante uma iteração, deve-se percorrer 'items' de trás para frente
+///
+/// @param pool Pool de onde o objeto foi obtido
+/// @param obj Objeto a ser devolvido
+void despawnObject(Pool *pool, Object *obj);
+
+/// Devolve uma partícula ao seu pool. O último item ativo passa a ocupar a posição da partícula devolvida em 'items', portanto ao devolver itens durante uma iteração, deve-se percorrer 'items' de trás para frente
+///
+/// @param pool Pool de onde a partícula foi obtida
+/// @param part Partícula a ser devolvida
+void despawnParticle(Pool *pool, Particle *part);
+
+/// Devolve todos os itens ativos ao pool
+///
+/// @param pool Pool a ser esvaziado
+void clearPool(Pool *pool);
+
+/// Libera a memória usada por um pool e por todos os seus itens. O modelo não é liberado
+///
+/// @param pool Pool a ser deletado
+void freePool(Pool *pool);
+
+#endif
@@ -0,0 +1,216 @@
+#include "rectarray.h"
+#include "simd.h"
+
+// Quantidade de retângulos de "b" processados por vez em intersectsPairs (32 palavras de máscara)
+#define PAIR_TILE 1024
+
+typedef void (*MaskKernel)(const RectangleArray *arr, int start, int words, const float *q, Uint32 *mask);
+
+void growRectangleArray(RectangleArray *arr, int capacity);
+int countAndTrim(RectangleArray *arr, int start, int words, Uint32 *mask);
+MaskKernel getMaskKernel();
+
+RectangleArray *newRectangleArray(int capacity)
+{
+	RectangleArray *arr = (RectangleArray *)taggedMalloc(sizeof(*arr), MEMORY_PHYSICS);
+	arr->left = arr->top = arr->right = arr->bottom = NULL;
+	arr->size = 0;
+	arr->capacity = 0;
+	growRectangleArray(arr, capacity > 0 ? capacity : 32);
+	return arr;
+}
+
+void addRectangle(RectangleArray *arr, Rectangle r)
+{
+	if (arr->size == arr->capacity) growRectangleArray(arr, arr->capacity * 2);
+	setRectangle(arr, arr->size++, r);
+}
+
+void setRectangle(RectangleArray *arr, int index, Rectangle r)
+{
+	arr->left[index] = r.position.x;
+	arr->top[index] = r.position.y;
+	arr->right[index] = r.position.x + r.size.x;
+	arr->bottom[index] = r.position.y + r.size.y;
+}
+
+Rectangle getRectangle(RectangleArray *arr, int index)
+{
+	return newRectangle(arr->left[index], arr->top[index],
+		arr->right[index] - arr->left[index], arr->bottom[index] - arr->top[index]);
+}
+
+void clearRectangleArray(RectangleArray *arr)
+{
+	arr->size = 0;
+}
+
+void freeRectangleArray(RectangleArray *arr)
+{
+	taggedFree(arr->left);
+	taggedFree(arr);
+}
+
+int intersectsMask(Rectangle r, RectangleArray *arr, Uint32 *mask)
+{
+	float q[4] = {r.position.x, r.position.y, r.position.x + r.size.x, r.position.y + r.size.y};
+	int words = (arr->size + 31) / 32;
+	if (words == 0) return 0;
+	getMaskKernel()(arr, 0, words, q, mask);
+	return countAndTrim(arr, 0, words, mask);
+}
+
+int intersectsIndices(Rectangle r, RectangleArray *arr, int *indices, int maxIndices)
+{
+	float q[4] = {r.position.x, r.position.y, r.position.x + r.size.x, r.position.y + r.size.y};
+	MaskKernel kernel = getMaskKernel();
+	Uint32 mask[8];
+	int start, count = 0;
+	for (start = 0; start < arr->size; start += 256)
+	{
+		int words = (arr->size - start + 31) / 32, w;
+		if (words > 8) words = 8;
+		kernel(arr, start, words, q, mask);
+		countAndTrim(arr, start, words, mask);
+		for (w = 0; w < words; w++)
+			while (mask[w])
+			{
+				if (count < maxIndices) indices[count] = start + w * 32 + __builtin_ctz(mask[w]);
+				count++;
+				mask[w] &= mask[w] - 1;
+			}
+	}
+	return count;
+}
+
+int intersectsPairs(RectangleArray *a, RectangleArray *b, int *pairs, int maxPairs)
+{
+	MaskKernel kernel = getMaskKernel();
+	Uint32 mask[PAIR_TILE / 32];
+	int start, i, count = 0;
+	for (start = 0; start < b->size; start += PAIR_TILE)
+	{
+		int words = (b->size - start + 31) / 32, w;
+		if (words > PAIR_TILE / 32) words = PAIR_TILE / 32;
+		for (i = 0; i < a->size; i++)
+		{
+			float q[4] = {a->left[i], a->top[i], a->right[i], a->bottom[i]};
+			kernel(b, start, words, q, mask);
+			countAndTrim(b, start, words, mask);
+			for (w = 0; w < words; w++)
+				while (mask[w])
+				{
+					if (count < maxPairs)
+					{
+						pairs[2 * count] = i;
+						pairs[2 * count + 1] = start + w * 32 + __builtin_ctz(mask[w]);
+					}
+					count++;
+					mask[w] &= mask[w] - 1;
+				}
+		}
+	}
+	return count;
+}
+
+void growRectangleArray(RectangleArray *arr, int capacity)
+{
+	capacity = (capacity + 31) & ~31;
+
+	// Os quatro vetores ficam num único bloco; o espaço além de 'size' é lido pelos testes em lote, por isso é inicializado
+	float *block = (float *)taggedMalloc(4 * capacity * sizeof(float), MEMORY_PHYSICS);
+	memset(block, 0, 4 * capacity * sizeof(float));
+	if (arr->left)
+	{
+		memcpy(block, arr->left, arr->size * sizeof(float));
+		memcpy(block + capacity, arr->top, arr->size * sizeof(float));
+		memcpy(block + 2 * capacity, arr->right, arr->size * sizeof(float));
+		memcpy(block + 3 * capacity, arr->bottom, arr->size * sizeof(float));
+		taggedFree(arr->left);
+	}
+	arr->left = block;
+	arr->top = block + capacity;
+	arr->right = block + 2 * capacity;
+	arr->bottom = block + 3 * capacity;
+	arr->capacity = capacity;
+}
+
+int countAndTrim(RectangleArray *arr, int start, int words, Uint32 *mask)
+{
+	int rest = arr->size - start - (words - 1) * 32, w, count = 0;
+	if (rest < 32) mask[words - 1] &= (1u << rest) - 1;
+	for (w = 0; w < words; w++)
+		count += __builtin_popcount(mask[w]);
+	return count;
+}
+
+void maskScalar(const RectangleArray *arr, int start, int words, const float *q, Uint32 *mask)
+{
+	int w, k;
+	for (w = 0; w < words; w++)
+	{
+		Uint32 bits = 0;
+		int base = start + w * 32;
+		for (k = 0; k < 32; k++)
+			bits |= (Uint32)(q[2] > arr->left[base + k] && arr->right[base + k] > q[0] &&
+				q[3] > arr->top[base + k] && arr->bottom[base + k] > q[1]) << k;
+		mask[w] = bits;
+	}
+}
+
+#ifdef MINI_X86
+__attribute__((target("sse2")))
+void maskSSE(const RectangleArray *arr, int start, int words, const float *q, Uint32 *mask)
+{
+	__m128 ql = _mm_set1_ps(q[0]), qt = _mm_set1_ps(q[1]), qr = _mm_set1_ps(q[2]), qb = _mm_set1_ps(q[3]);
+	int w, k;
+	for (w = 0; w < words; w++)
+	{
+		Uint32 bits = 0;
+		for (k = 0; k < 8; k++)
+		{
+			int i = start + w * 32 + k * 4;
+			__m128 x = _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(arr->left + i), qr), _mm_cmpgt_ps(_mm_loadu_ps(arr->right + i), ql));
+			__m128 y = _mm_and_ps(_mm_cmplt_ps(_mm_loadu_ps(arr->top + i), qb), _mm_cmpgt_ps(_mm_loadu_ps(arr->bottom + i), qt));
+			bits |= (Uint32)_mm_movemask_ps(_mm_and_ps(x, y)) << (k * 4);
+		}
+		mask[w] = bits;
+	}
+}
+
+__attribute__((target("avx")))
+void maskAVX(const RectangleArray *arr, int start, int words, const float *q, Uint32 *mask)
+{
+	__m256 ql = _mm256_set1_ps(q[0]), qt = _mm256_set1_ps(q[1]), qr = _mm256_set1_ps(q[2]), qb = _mm256_set1_ps(q[3]);
+	int w, k;
+	for (w = 0; w < words; w++)
+	{
+		Uint32 bits = 0;
+		for (k = 0; k < 4; k++)
+		{
+			int i = start + w * 32 + k * 8;
+			__m256 x = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(arr->left + i), qr, _CMP_LT_OQ),
+				_mm256_cmp_ps(_mm256_loadu_ps(arr->right + i), ql, _CMP_GT_OQ));
+			__m256 y = _mm256_and_ps(_mm256_cmp_ps(_mm256_loadu_ps(arr->top + i), qb, _CMP_LT_OQ),
+				_mm256_cmp_ps(_mm256_loadu_ps(arr->bottom + i), qt, _CMP_GT_OQ));
+			bits |= (Uint32)_mm256_movemask_ps(_mm256_and_ps(x, y)) << (k * 8);
+		}
+		mask[w] = bits;
+	}
+}
+#endif
+
+MaskKernel getMaskKernel()
+{
+	static MaskKernel kernel = NULL;
+	if (kernel == NULL)
+	{
+#ifdef MINI_X86
+		SimdLevel simd = getSimdLevel();
+		kernel = simd == SIMD_AVX ? maskAVX : simd == SIMD_SSE2 ? maskSSE : maskScalar;
+#else
+		kernel = maskScalar;
+#endif
+	}
+	return kernel;
+}
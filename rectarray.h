@@ -0,0 +1,91 @@
+/** @file */
+
+#ifndef MINI_RECTARRAY_H
+#define MINI_RECTARRAY_H
+
+#include "support.h"
+
+/// Vetor compacto de retângulos, guardados como quatro vetores de coordenadas (esquerda, topo, direita e base), usado para testes de intersecção em lote com instruções SIMD
+typedef struct {
+	/// Coordenada x da borda esquerda de cada retângulo
+	float *left;
+
+	/// Coordenada y da borda superior de cada retângulo
+	float *top;
+
+	/// Coordenada x da borda direita de cada retângulo (x + largura)
+	float *right;
+
+	/// Coordenada y da borda inferior de cada retângulo (y + altura)
+	float *bottom;
+
+	/// Total de retângulos no vetor
+	int size;
+
+	/// Total de retângulos que cabem no vetor sem realocação. É sempre múltiplo de 32
+	int capacity;
+} RectangleArray;
+
+/// Cria um vetor de retângulos vazio
+///
+/// @param capacity Quantidade de retângulos que cabem no vetor antes de ser necessário realocá-lo
+/// @return O vetor gerado
+RectangleArray *newRectangleArray(int capacity);
+
+/// Adiciona um retângulo ao final de um vetor de retângulos
+///
+/// @param arr Vetor onde o retângulo será adicionado
+/// @param r Retângulo a adicionar
+void addRectangle(RectangleArray *arr, Rectangle r);
+
+/// Substitui o retângulo numa posição de um vetor de retângulos
+///
+/// @param arr Vetor a ser alterado
+/// @param index Posição do retângulo no vetor
+/// @param r Novo retângulo
+void setRectangle(RectangleArray *arr, int index, Rectangle r);
+
+/// Retorna o retângulo numa posição de um vetor de retângulos
+///
+/// @param arr Vetor de retângulos
+/// @param index Posição do retângulo no vetor
+/// @return O retângulo na posição dada
+Rectangle getRectangle(RectangleArray *arr, int index);
+
+/// Remove todos os retângulos de um vetor de retângulos
+///
+/// @param arr Vetor a ser limpo
+void clearRectangleArray(RectangleArray *arr);
+
+/// Libera a memória usada por um vetor de retângulos
+///
+/// @param arr Vetor a ser deletado
+void freeRectangleArray(RectangleArray *arr);
+
+/// Testa um retângulo contra todos os retângulos de um vetor, com o mesmo critério e os mesmos resultados da função intersects. Usa AVX ou SSE quando o processador permite
+///
+/// @param r Retângulo a ser testado
+/// @param arr Vetor de retângulos
+/// @param mask Vetor com pelo menos (arr->size + 31) / 32 posições, onde o bit i % 32 da posição i / 32 indicará se há intersecção com o retângulo i
+/// @return Total de retângulos do vetor que interceptam 'r'
+int intersectsMask(Rectangle r, RectangleArray *arr, Uint32 *mask);
+
+/// Testa um retângulo contra todos os retângulos de um vetor, retornando as posições dos que o interceptam, em ordem crescente
+///
+/// @param r Retângulo a ser testado
+/// @param arr Vetor de retângulos
+/// @param indices Vetor onde serão escritas as posições dos retângulos que interceptam 'r'
+/// @param maxIndices Tamanho do vetor 'indices'
+/// @return Total de retângulos do vetor que interceptam 'r'. Se for maior que 'maxIndices', apenas as primeiras 'maxIndices' posições foram escritas
+int intersectsIndices(Rectangle r, RectangleArray *arr, int *indices, int maxIndices);
+
+/// Testa todos os retângulos de um vetor contra todos os de outro, processando-os em blocos para aproveitar o cache
+///
+/// @param a Um vetor de retângulos
+/// @param b Outro vetor de retângulos
+/// @param pairs Vetor onde serão escritos os pares que se interceptam: a posição em 'a' em pairs[2k] e a posição em 'b' em pairs[2k + 1]
+/// @param maxPairs Máximo de pares que cabem em 'pairs' (que deve ter 2 * maxPairs posições)
+/// @return Total de pares que se interceptam. Se for maior que 'maxPairs', apenas os primeiros 'maxPairs' pares foram escritos
+int intersectsPairs(RectangleArray *a, RectangleArray *b, int *pairs, int maxPairs);
+
+#endif
@@ -0,0 +1,32 @@
+/** @file */
+
+#ifndef MINI_SIMD_H
+#define MINI_SIMD_H
+
+#include "support.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+
+/// Definida quando a compilação é para x86, onde há versões SSE e AVX dos laços mais pesados, escolhidas em tempo de execução
+#define MINI_X86
+#endif
+
+/// Conjunto de instruções vetoriais mais amplo suportado pelo processador
+typedef enum {
+	/// Nenhum conjunto suportado (ou compilação fora do x86): apenas as versões escalares podem ser usadas
+	SIMD_NONE,
+
+	/// SSE2, com vetores de 4 floats
+	SIMD_SSE2,
+
+	/// AVX, com vetores de 8 floats
+	SIMD_AVX
+} SimdLevel;
+
+/// Retorna o conjunto de instruções vetoriais suportado pelo processador. A detecção é feita uma única vez
+///
+/// @return O conjunto mais amplo suportado
+SimdLevel getSimdLevel();
+
+#endif
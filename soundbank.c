@@ -0,0 +1,83 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "soundbank.h"
+
+SoundBank *loadSoundBank(const char *fileName)
+{
+	int file = open(fileName, O_RDONLY);
+	if (file < 0)
+	{
+		printf("Erro ao abrir o banco de sons %s\n", fileName);
+		return NULL;
+	}
+	struct stat info;
+	void *data = MAP_FAILED;
+	if (fstat(file, &info) == 0 && (size_t)info.st_size >= sizeof(SoundBankHeader))
+		data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED)
+	{
+		printf("Erro ao ler o banco de sons %s\n", fileName);
+		return NULL;
+	}
+
+	// O banco só é aceito se as amostras estiverem exatamente no formato em que o mixer foi aberto
+	SoundBankHeader *header = (SoundBankHeader *)data;
+	int frequency, channels;
+	Uint16 format;
+	Mix_QuerySpec(&frequency, &format, &channels);
+	if (memcmp(header->magic, SOUND_BANK_MAGIC, 4) != 0 || header->version != SOUND_BANK_VERSION ||
+		sizeof(SoundBankHeader) + header->count * sizeof(SoundBankEntry) > (size_t)info.st_size)
+	{
+		printf("Banco de sons inválido: %s\n", fileName);
+		munmap(data, info.st_size);
+		return NULL;
+	}
+	if ((int)header->frequency != frequency || header->format != format || header->channels != channels)
+	{
+		printf("O banco de sons %s (%d Hz, formato %x, %d canais) não está no formato do mixer (%d Hz, formato %x, %d canais)\n",
+			fileName, header->frequency, header->format, header->channels, frequency, format, channels);
+		munmap(data, info.st_size);
+		return NULL;
+	}
+
+	SoundBank *bank = (SoundBank *)taggedMalloc(sizeof(*bank), MEMORY_CONTROL);
+	bank->data = (Uint8 *)data;
+	bank->size = info.st_size;
+	bank->count = header->count;
+	bank->entries = (SoundBankEntry *)(bank->data + sizeof(SoundBankHeader));
+	bank->sounds = (Sound *)taggedMalloc((bank->count + 1) * sizeof(Sound), MEMORY_CONTROL);
+	int i;
+	for (i = 0; i < bank->count; i++)
+	{
+		SoundBankEntry *e = &bank->entries[i];
+		Sound *s = &bank->sounds[i];
+		s->allocated = 0;
+		s->abuf = (size_t)e->offset + e->length <= bank->size ? bank->data + e->offset : NULL;
+		s->alen = s->abuf ? e->length : 0;
+		s->volume = MIX_MAX_VOLUME;
+	}
+	return bank;
+}
+
+Sound *getBankSound(SoundBank *bank, const char *name)
+{
+	int low = 0, high = bank->count - 1;
+	while (low <= high)
+	{
+		int middle = (low + high) / 2, cmp = strncmp(name, bank->entries[middle].name, SOUND_BANK_NAME_SIZE);
+		if (cmp == 0) return &bank->sounds[middle];
+		if (cmp < 0) high = middle - 1;
+		else low = middle + 1;
+	}
+	return NULL;
+}
+
+void freeSoundBank(SoundBank *bank)
+{
+	munmap(bank->data, bank->size);
+	taggedFree(bank->sounds);
+	taggedFree(bank);
+}
@@ -0,0 +1,89 @@
+/** @file */
+
+#ifndef MINI_SOUNDBANK_H
+#define MINI_SOUNDBANK_H
+
+#include "control.h"
+
+/// Identificação dos arquivos de banco de sons
+#define SOUND_BANK_MAGIC "MSBK"
+
+/// Versão atual do formato dos bancos de sons
+#define SOUND_BANK_VERSION 1
+
+/// Tamanho máximo, incluindo o terminador, do nome de um som num banco
+#define SOUND_BANK_NAME_SIZE 32
+
+/// Alinhamento, em bytes, das amostras de cada som dentro do arquivo
+#define SOUND_BANK_ALIGN 16
+
+/// Cabeçalho de um arquivo de banco de sons, seguido por 'count' entradas (SoundBankEntry) e pelas amostras. Os números estão na ordem de bytes da máquina que gerou o arquivo
+typedef struct {
+	/// Identificação do formato (SOUND_BANK_MAGIC)
+	char magic[4];
+
+	/// Versão do formato (SOUND_BANK_VERSION)
+	Uint32 version;
+
+	/// Frequência de amostragem, em Hz
+	Uint32 frequency;
+
+	/// Formato das amostras, como em Mix_QuerySpec (por exemplo, AUDIO_S16SYS)
+	Uint16 format;
+
+	/// Total de canais (1 para mono, 2 para estéreo)
+	Uint16 channels;
+
+	/// Total de sons
+	Uint32 count;
+} SoundBankHeader;
+
+/// Entrada de um som no arquivo de banco de sons
+typedef struct {
+	/// Nome do som (o nome do arquivo original, sem diretório e extensão). As entradas estão em ordem crescente de nome
+	char name[SOUND_BANK_NAME_SIZE];
+
+	/// Posição das amostras, em bytes desde o início do arquivo. Sempre múltiplo de SOUND_BANK_ALIGN
+	Uint32 offset;
+
+	/// Tamanho das amostras, em bytes
+	Uint32 length;
+} SoundBankEntry;
+
+/// Banco de sons já decodificados no formato de saída do mixer, guardados em sequência num único arquivo mapeado em memória (mmap). Carregar um banco não decodifica nem copia nenhuma amostra, e tocar um som do banco custa o mesmo que tocar qualquer outro. Os arquivos são gerados pela ferramenta tools/soundbank
+typedef struct {
+	/// Conteúdo do arquivo, mapeado em memória
+	Uint8 *data;
+
+	/// Tamanho do arquivo, em bytes
+	size_t size;
+
+	/// Entradas dos sons, dentro de 'data'
+	SoundBankEntry *entries;
+
+	/// Sons do banco, na ordem das entradas, alocados num único bloco. As amostras de cada um apontam para dentro de 'data'
+	Sound *sounds;
+
+	/// Total de sons
+	int count;
+} SoundBank;
+
+/// Carrega um banco de sons. O áudio já deve ter sido inicializado (ver initializeAudio), com o mesmo formato usado na geração do banco
+///
+/// @param fileName Nome do arquivo do banco
+/// @return O banco carregado, ou nulo se o arquivo não puder ser lido ou não estiver no formato do mixer
+SoundBank *loadSoundBank(const char *fileName);
+
+/// Retorna um som de um banco pelo nome, com busca binária
+///
+/// @param bank Banco a ser consultado
+/// @param name Nome do som
+/// @return O som, que pode ser usado com playSound e playSoundVoice mas não deve ser liberado com freeSound, ou nulo se não existir
+Sound *getBankSound(SoundBank *bank, const char *name);
+
+/// Libera um banco de sons. Nenhum de seus sons pode estar tocando
+///
+/// @param bank Banco a ser deletado
+void freeSoundBank(SoundBank *bank);
+
+#endif
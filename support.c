@@ -1,13 +1,31 @@
-#include "support.h"
+#include <math.h>
+#include <time.h>
+#include "simd.h"
+
+#ifndef NDEBUG
+// Cabeçalho guardado antes de cada bloco alocado por taggedMalloc. A união com long double mantém o alinhamento
+typedef union {
+	struct {
+		size_t size;
+		MemoryTag tag;
+	} info;
+	long double align;
+} AllocHeader;
+
+MemoryStats memoryStats;
+int currentFrameAllocations;
+#endif
+
+const char *MEMORY_TAG_NAMES[MEMORY_TAGS] = {"jogo", "listas", "imagens", "objetos", "partículas", "textos", "componentes", "controle", "física"};
 
 void checkIndex(List *, int);
 void clearItems(List *list, void (*freeItem)(void *));
 
 List *newList()
 {
-	List *list = (List *)safeMalloc(sizeof(List));
-	list->head = (Node *)safeMalloc(sizeof(Node));
-	list->tail = (Node *)safeMalloc(sizeof(Node));
+	List *list = (List *)taggedMalloc(sizeof(List), MEMORY_LIST);
+	list->head = (Node *)taggedMalloc(sizeof(Node), MEMORY_LIST);
+	list->tail = (Node *)taggedMalloc(sizeof(Node), MEMORY_LIST);
 	list->head->item = list->head->prev = list->tail->item = list->tail->next = NULL;
 	list->head->next = list->tail;
 	list->tail->prev = list->head;
@@ -18,7 +36,7 @@ List *newList()
 
 void addItem(List *list, void *item)
 {
-    Node *newNode = (Node *)safeMalloc(sizeof(Node));
+    Node *newNode = (Node *)taggedMalloc(sizeof(Node), MEMORY_LIST);
     newNode->item = item;
     newNode->next = list->tail;
     newNode->prev = list->tail->prev;
@@ -31,7 +49,7 @@ void insertItem(List *list, int index, void *item)
 {
 	checkIndex(list, index);
 
-	Node *aux = list->head, *newNode = (Node *)safeMalloc(sizeof(Node));
+	Node *aux = list->head, *newNode = (Node *)taggedMalloc(sizeof(Node), MEMORY_LIST);
 	newNode->item = item;
 	int i = 0;
 	while (i++ < index)
@@ -54,7 +72,7 @@ void removeItem(List *list, int index, void (*freeItem)(void *))
 	aux->prev->next = aux->next;
 	aux->next->prev = aux->prev;
 	if (freeItem) freeItem(aux->item);
-	free(aux);
+	taggedFree(aux);
 	list->size--;
 }
 
@@ -63,7 +81,7 @@ void removeNode(List *list, Node *node, void (*freeItem)(void *))
 	node->prev->next = node->next;
 	node->next->prev = node->prev;
 	if (freeItem) freeItem(node->item);
-	free(node);
+	taggedFree(node);
 	list->size--;
 }
 
@@ -94,9 +112,9 @@ void freeList(List *list, void (*freeItem)(void *))
 
 void freeListAux(List *list)
 {
-	free(list->head);
-	free(list->tail);
-	free(list);
+	taggedFree(list->head);
+	taggedFree(list->tail);
+	taggedFree(list);
 }
 
 Point newPoint(float x, float y)
@@ -112,7 +130,100 @@ int roundFloat(float f)
 }
 int randomNumber(int from, int to)
 {
-	return roundFloat((to - from) * ((float)rand()/RAND_MAX) + from);
+	if (from > to) return randomInt(getThreadRandom(), to, from);
+	return randomInt(getThreadRandom(), from, to);
+}
+
+Uint64 splitMix(Uint64 *x)
+{
+	Uint64 z = (*x += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+void seedRandom(Random *rng, Uint64 seed)
+{
+	Uint64 a = splitMix(&seed), b = splitMix(&seed);
+	rng->state[0] = (Uint32)a; rng->state[1] = (Uint32)(a >> 32);
+	rng->state[2] = (Uint32)b; rng->state[3] = (Uint32)(b >> 32);
+}
+static inline Uint32 rotateLeft(Uint32 x, int k)
+{
+	return (x << k) | (x >> (32 - k));
+}
+Uint32 nextRandom(Random *rng)
+{
+	Uint32 *s = rng->state;
+	Uint32 result = rotateLeft(s[1] * 5, 7) * 9, t = s[1] << 9;
+	s[2] ^= s[0];
+	s[3] ^= s[1];
+	s[1] ^= s[2];
+	s[0] ^= s[3];
+	s[2] ^= t;
+	s[3] = rotateLeft(s[3], 11);
+	return result;
+}
+static inline Uint32 boundedRandom(Random *rng, Uint32 range)
+{
+	// Método de Lemire: multiplicação seguida de rejeição apenas na pequena faixa que causaria viés
+	Uint64 m = (Uint64)nextRandom(rng) * range;
+	if ((Uint32)m < range)
+	{
+		Uint32 threshold = -range % range;
+		while ((Uint32)m < threshold)
+			m = (Uint64)nextRandom(rng) * range;
+	}
+	return m >> 32;
+}
+static inline float limitRandomFloat(float value, float from, float to)
+{
+	// O arredondamento de from + (to - from) * u pode chegar a 'to' mesmo com u < 1, e o limite superior não pode ser gerado
+	if (from < to ? value >= to : from > to && value <= to) return nextafterf(to, from);
+	return value;
+}
+int randomInt(Random *rng, int from, int to)
+{
+	Uint32 range = (Uint32)to - (Uint32)from + 1;
+	if (range == 0) return (int)nextRandom(rng);
+	return (int)((Uint32)from + boundedRandom(rng, range));
+}
+float randomFloat(Random *rng, float from, float to)
+{
+	return limitRandomFloat(from + (to - from) * ((nextRandom(rng) >> 8) * (1.0f / 16777216.0f)), from, to);
+}
+void fillRandomInts(Random *rng, int *values, int count, int from, int to)
+{
+	Uint32 range = (Uint32)to - (Uint32)from + 1;
+	int i;
+	if (range == 0)
+		for (i = 0; i < count; i++)
+			values[i] = (int)nextRandom(rng);
+	else
+		for (i = 0; i < count; i++)
+			values[i] = (int)((Uint32)from + boundedRandom(rng, range));
+}
+void fillRandomFloats(Random *rng, float *values, int count, float from, float to)
+{
+	float scale = (to - from) * (1.0f / 16777216.0f);
+	int i;
+	for (i = 0; i < count; i++)
+		values[i] = limitRandomFloat(from + (nextRandom(rng) >> 8) * scale, from, to);
+}
+Random *getThreadRandom()
+{
+	static __thread Random threadRandom;
+	static __thread bool seeded = false;
+	static Uint64 streams = 0;
+	if (!seeded)
+	{
+		seedRandom(&threadRandom, (Uint64)time(NULL) ^ (__sync_add_and_fetch(&streams, 1) << 32));
+		seeded = true;
+	}
+	return &threadRandom;
+}
+void setRandomSeed(Uint64 seed)
+{
+	seedRandom(getThreadRandom(), seed);
 }
 
 Rectangle newRectangle(float x, float y, float width, float height)
@@ -131,7 +242,7 @@ bool intersects(Rectangle a, Rectangle b)
 
 Image *newImage(const char *fileName)
 {
-	Image *img = (Image *)safeMalloc(sizeof(*img));
+	Image *img = (Image *)taggedMalloc(sizeof(*img), MEMORY_IMAGE);
 	img->surface = IMG_Load(fileName);
 	SDL_Surface *opt = SDL_DisplayFormatAlpha(img->surface);
 	if (opt)
@@ -147,7 +258,7 @@ Image *newImage(const char *fileName)
 void freeImage(Image *img)
 {
 	SDL_FreeSurface(img->surface);
-	free(img);
+	taggedFree(img);
 }
 
 void *safeMalloc(size_t size)
@@ -161,6 +272,92 @@ void *safeMalloc(size_t size)
 	return p;
 }
 
+#ifndef NDEBUG
+void *taggedMalloc(size_t size, MemoryTag tag)
+{
+	AllocHeader *h = (AllocHeader *)safeMalloc(sizeof(AllocHeader) + size);
+	h->info.size = size;
+	h->info.tag = tag;
+	memoryStats.allocations[tag]++;
+	memoryStats.liveBlocks[tag]++;
+	memoryStats.liveBytes[tag] += size;
+	memoryStats.totalLiveBytes += size;
+	if (memoryStats.totalLiveBytes > memoryStats.peakBytes) memoryStats.peakBytes = memoryStats.totalLiveBytes;
+	currentFrameAllocations++;
+	return h + 1;
+}
+void taggedFree(void *p)
+{
+	if (p == NULL) return;
+	AllocHeader *h = (AllocHeader *)p - 1;
+	memoryStats.liveBlocks[h->info.tag]--;
+	memoryStats.liveBytes[h->info.tag] -= h->info.size;
+	memoryStats.totalLiveBytes -= h->info.size;
+	free(h);
+}
+MemoryStats getMemoryStats()
+{
+	return memoryStats;
+}
+void endMemoryFrame()
+{
+	memoryStats.frameAllocations = currentFrameAllocations;
+	currentFrameAllocations = 0;
+}
+void reportMemoryLeaks()
+{
+	// O pico só é mostrado junto com vazamentos; fora disso está disponível em getMemoryStats
+	int i;
+	bool leaked = false;
+	for (i = 0; i < MEMORY_TAGS; i++)
+		if (memoryStats.liveBlocks[i] > 0)
+		{
+			printf("Memória não liberada (%s): %d blocos, %lu bytes\n", MEMORY_TAG_NAMES[i],
+				memoryStats.liveBlocks[i], (unsigned long)memoryStats.liveBytes[i]);
+			leaked = true;
+		}
+	if (leaked) printf("Pico de memória: %lu bytes\n", (unsigned long)memoryStats.peakBytes);
+}
+#else
+void *taggedMalloc(size_t size, MemoryTag tag)
+{
+	return safeMalloc(size);
+}
+void taggedFree(void *p)
+{
+	free(p);
+}
+MemoryStats getMemoryStats()
+{
+	MemoryStats stats;
+	memset(&stats, 0, sizeof(stats));
+	return stats;
+}
+void endMemoryFrame()
+{
+}
+void reportMemoryLeaks()
+{
+}
+#endif
+
+SimdLevel getSimdLevel()
+{
+	static int level = -1;
+	if (level < 0)
+	{
+#ifdef MINI_X86
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx")) level = SIMD_AVX;
+		else if (__builtin_cpu_supports("sse2")) level = SIMD_SSE2;
+		else level = SIMD_NONE;
+#else
+		level = SIMD_NONE;
+#endif
+	}
+	return (SimdLevel)level;
+}
+
 void checkIndex(List *list, int index)
 {
 	if (index > list->size-1 || index < 0)
@@ -177,7 +374,7 @@ void clearItems(List *list, void (*freeItem)(void *))
 	{
 		Node *next = n->next;
 		if (freeItem) freeItem(n->item);
-		free(n);
+		taggedFree(n);
 		n = next;
 	}
 }
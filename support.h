@@ -140,6 +140,66 @@ typedef struct {
 	int size;
 } List;
 
+/// Estado de um gerador de números pseudo-aleatórios (algoritmo xoshiro128**). Cada subsistema ou thread pode ter seu próprio gerador, com semente independente
+typedef struct {
+	/// Estado interno do gerador
+	Uint32 state[4];
+} Random;
+
+/// Categorias usadas para contabilizar a memória alocada pela biblioteca (ver taggedMalloc)
+typedef enum {
+	/// Memória alocada pelo jogo através de taggedMalloc
+	MEMORY_GAME,
+
+	/// Listas e seus nós
+	MEMORY_LIST,
+
+	/// Imagens
+	MEMORY_IMAGE,
+
+	/// Objetos e suas sprite sheets
+	MEMORY_OBJECT,
+
+	/// Partículas
+	MEMORY_PARTICLE,
+
+	/// Textos
+	MEMORY_TEXT,
+
+	/// Botões e campos de texto
+	MEMORY_COMPONENTS,
+
+	/// Estruturas internas de controle (entrada, áudio, etc.)
+	MEMORY_CONTROL,
+
+	/// Estruturas de colisão e simulação física
+	MEMORY_PHYSICS,
+
+	/// Total de categorias
+	MEMORY_TAGS
+} MemoryTag;
+
+/// Estatísticas de uso de memória. Só são coletadas em compilações de depuração (sem NDEBUG)
+typedef struct {
+	/// Total de alocações feitas desde o início, por categoria
+	int allocations[MEMORY_TAGS];
+
+	/// Blocos ainda não liberados, por categoria
+	int liveBlocks[MEMORY_TAGS];
+
+	/// Bytes ainda não liberados, por categoria
+	size_t liveBytes[MEMORY_TAGS];
+
+	/// Total de bytes ainda não liberados
+	size_t totalLiveBytes;
+
+	/// Máximo de bytes simultaneamente alocados desde o início
+	size_t peakBytes;
+
+	/// Alocações feitas no último frame completo
+	int frameAllocations;
+} MemoryStats;
+
 /// Cria uma lista genérica vazia
 ///
 /// @return Uma lista genérica vazia
@@ -208,13 +268,69 @@ Point newPoint(float x, float y);
 /// @return Resultado do arredondamento
 int roundFloat(float f);
 
-/// Gera um inteiro aletório entre 'from' e 'to'
+/// Gera um inteiro aletório entre 'from' e 'to', usando o gerador padrão da thread atual (ver getThreadRandom). Todos os valores do intervalo têm a mesma probabilidade
 ///
 /// @param from Mínimo inteiro que pode ser gerado. Pode ser negativo
 /// @param to Máximo inteiro que pode ser gerado. Pode ser negativo
 /// @return Número gerado
 int randomNumber(int from, int to);
 
+/// Inicializa um gerador de números pseudo-aleatórios. Geradores com a mesma semente produzem a mesma sequência
+///
+/// @param rng Gerador a ser inicializado
+/// @param seed Semente
+void seedRandom(Random *rng, Uint64 seed);
+
+/// Gera 32 bits aleatórios
+///
+/// @param rng Gerador a ser usado
+/// @return Número gerado
+Uint32 nextRandom(Random *rng);
+
+/// Gera um inteiro aleatório entre 'from' e 'to' (inclusive), sem viés: todos os valores do intervalo têm a mesma probabilidade
+///
+/// @param rng Gerador a ser usado
+/// @param from Mínimo inteiro que pode ser gerado. Pode ser negativo
+/// @param to Máximo inteiro que pode ser gerado. Pode ser negativo
+/// @return Número gerado
+int randomInt(Random *rng, int from, int to);
+
+/// Gera um float aleatório uniformemente distribuído no intervalo ['from', 'to'). Resultados que o arredondamento levaria a 'to' são trocados pelo float imediatamente anterior a ele
+///
+/// @param rng Gerador a ser usado
+/// @param from Limite inferior do intervalo
+/// @param to Limite superior do intervalo (não incluso)
+/// @return Número gerado
+float randomFloat(Random *rng, float from, float to);
+
+/// Preenche um vetor com inteiros aleatórios entre 'from' e 'to' (inclusive). Mais rápido que chamadas repetidas a randomInt
+///
+/// @param rng Gerador a ser usado
+/// @param values Vetor a ser preenchido
+/// @param count Quantidade de números a gerar
+/// @param from Mínimo inteiro que pode ser gerado
+/// @param to Máximo inteiro que pode ser gerado
+void fillRandomInts(Random *rng, int *values, int count, int from, int to);
+
+/// Preenche um vetor com floats aleatórios no intervalo ['from', 'to'), limitados como em randomFloat. Mais rápido que chamadas repetidas a randomFloat
+///
+/// @param rng Gerador a ser usado
+/// @param values Vetor a ser preenchido
+/// @param count Quantidade de números a gerar
+/// @param from Limite inferior do intervalo
+/// @param to Limite superior do intervalo (não incluso)
+void fillRandomFloats(Random *rng, float *values, int count, float from, float to);
+
+/// Retorna o gerador padrão da thread atual. Cada thread tem o seu, inicializado com uma semente diferente na primeira chamada
+///
+/// @return Gerador da thread atual
+Random *getThreadRandom();
+
+/// Define a semente do gerador padrão da thread atual, tornando determinística a sequência gerada por randomNumber
+///
+/// @param seed Semente
+void setRandomSeed(Uint64 seed);
+
 /// Cria um retângulo
 ///
 /// @param x Coordenada x do retângulo
@@ -248,5 +364,28 @@ void freeImage(Image *img);
 /// @return Ponteiro para o espaço alocado
 void *safeMalloc(size_t size);
 
+/// Aloca espaço na memória contabilizando-o numa categoria, e encerra o programa caso haja erro. Em compilações com NDEBUG equivale a safeMalloc
+///
+/// @param size Espaço em bytes a ser alocado
+/// @param tag Categoria na qual a alocação será contabilizada
+/// @return Ponteiro para o espaço alocado. Deve ser liberado com taggedFree
+void *taggedMalloc(size_t size, MemoryTag tag);
+
+/// Libera um espaço alocado por taggedMalloc. Em compilações com NDEBUG equivale a free
+///
+/// @param p Ponteiro para o espaço a ser liberado. Pode ser nulo
+void taggedFree(void *p);
+
+/// Retorna as estatísticas de uso de memória. Em compilações com NDEBUG, todos os campos serão zero
+///
+/// @return Estatísticas atuais
+MemoryStats getMemoryStats();
+
+/// Encerra a contagem de alocações do frame atual. Chamada automaticamente ao final de cada frame do laço principal
+void endMemoryFrame();
+
+/// Imprime os blocos de memória ainda não liberados, por categoria, e o pico de memória, apenas se houver vazamentos. Chamada automaticamente por finalize
+void reportMemoryLeaks();
+
 #endif
 
@@ -0,0 +1,127 @@
+#include "threadpool.h"
+
+typedef struct {
+	ThreadPool *pool;
+	int index;
+} Worker;
+
+struct ThreadPool {
+	SDL_Thread **threads;
+	Worker *workers;
+	int numThreads;
+	SDL_mutex *lock;
+	SDL_cond *start;
+	SDL_cond *done;
+	int generation;
+	int pending;
+	bool quit;
+	ParallelFunc func;
+	int count;
+	void *data;
+};
+
+int runWorker(void *data);
+void runPart(ThreadPool *pool, int index);
+
+ThreadPool *newThreadPool(int threads)
+{
+	ThreadPool *pool = (ThreadPool *)taggedMalloc(sizeof(*pool), MEMORY_CONTROL);
+	pool->numThreads = threads > 1 ? threads : 1;
+	pool->lock = SDL_CreateMutex();
+	pool->start = SDL_CreateCond();
+	pool->done = SDL_CreateCond();
+	pool->generation = 0;
+	pool->pending = 0;
+	pool->quit = false;
+	pool->threads = (SDL_Thread **)taggedMalloc(pool->numThreads * sizeof(SDL_Thread *), MEMORY_CONTROL);
+	pool->workers = (Worker *)taggedMalloc(pool->numThreads * sizeof(Worker), MEMORY_CONTROL);
+	int i;
+	for (i = 1; i < pool->numThreads; i++)
+	{
+		pool->workers[i].pool = pool;
+		pool->workers[i].index = i;
+		pool->threads[i] = SDL_CreateThread(runWorker, &pool->workers[i]);
+	}
+	return pool;
+}
+
+int getThreadCount(ThreadPool *pool)
+{
+	return pool ? pool->numThreads : 1;
+}
+
+void runParallel(ThreadPool *pool, ParallelFunc func, int count, void *data)
+{
+	if (pool == NULL || pool->numThreads == 1)
+	{
+		func(0, count, 0, data);
+		return;
+	}
+
+	SDL_LockMutex(pool->lock);
+	pool->func = func;
+	pool->count = count;
+	pool->data = data;
+	pool->pending = pool->numThreads - 1;
+	pool->generation++;
+	SDL_CondBroadcast(pool->start);
+	SDL_UnlockMutex(pool->lock);
+
+	runPart(pool, 0);
+
+	SDL_LockMutex(pool->lock);
+	while (pool->pending > 0)
+		SDL_CondWait(pool->done, pool->lock);
+	SDL_UnlockMutex(pool->lock);
+}
+
+void freeThreadPool(ThreadPool *pool)
+{
+	SDL_LockMutex(pool->lock);
+	pool->quit = true;
+	SDL_CondBroadcast(pool->start);
+	SDL_UnlockMutex(pool->lock);
+
+	int i;
+	for (i = 1; i < pool->numThreads; i++)
+		SDL_WaitThread(pool->threads[i], NULL);
+	SDL_DestroyCond(pool->start);
+	SDL_DestroyCond(pool->done);
+	SDL_DestroyMutex(pool->lock);
+	taggedFree(pool->threads);
+	taggedFree(pool->workers);
+	taggedFree(pool);
+}
+
+int runWorker(void *data)
+{
+	Worker *w = (Worker *)data;
+	ThreadPool *pool = w->pool;
+	int seen = 0;
+	while (true)
+	{
+		SDL_LockMutex(pool->lock);
+		while (pool->generation == seen && !pool->quit)
+			SDL_CondWait(pool->start, pool->lock);
+		if (pool->quit)
+		{
+			SDL_UnlockMutex(pool->lock);
+			return 0;
+		}
+		seen = pool->generation;
+		SDL_UnlockMutex(pool->lock);
+
+		runPart(pool, w->index);
+
+		SDL_LockMutex(pool->lock);
+		if (--pool->pending == 0) SDL_CondSignal(pool->done);
+		SDL_UnlockMutex(pool->lock);
+	}
+}
+
+void runPart(ThreadPool *pool, int index)
+{
+	int first = (int)((long long)pool->count * index / pool->numThreads),
+		last = (int)((long long)pool->count * (index + 1) / pool->numThreads);
+	if (first < last) pool->func(first, last, index, pool->data);
+}
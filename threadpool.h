@@ -0,0 +1,45 @@
+/** @file */
+
+#ifndef MINI_THREADPOOL_H
+#define MINI_THREADPOOL_H
+
+#include "SDL/SDL_thread.h"
+#include "support.h"
+
+/// Grupo de threads que executam juntas uma mesma função sobre partes de um intervalo de índices
+typedef struct ThreadPool ThreadPool;
+
+/// Função executada em paralelo por runParallel
+///
+/// @param first Primeiro índice da parte a processar
+/// @param last Índice seguinte ao último da parte a processar
+/// @param thread Número da thread, de 0 a getThreadCount - 1. A thread que chamou runParallel é a de número 0
+/// @param data Parâmetro repassado por runParallel
+typedef void (*ParallelFunc)(int first, int last, int thread, void *data);
+
+/// Cria um grupo de threads. A thread que chama runParallel também participa do trabalho, portanto são criadas 'threads' - 1 threads novas
+///
+/// @param threads Total de threads que executarão o trabalho
+/// @return O grupo gerado
+ThreadPool *newThreadPool(int threads);
+
+/// Retorna o total de threads de um grupo
+///
+/// @param pool Grupo de threads. Se for nulo, retorna 1
+/// @return Total de threads, contando a que chama runParallel
+int getThreadCount(ThreadPool *pool);
+
+/// Divide o intervalo [0, count) em partes contíguas e de tamanhos próximos, uma por thread, e executa 'func' sobre elas em paralelo. Retorna apenas quando todas as partes foram processadas. A parte de cada thread depende apenas de 'count' e do total de threads
+///
+/// @param pool Grupo de threads. Se for nulo, 'func' é executada uma única vez, sobre todo o intervalo, pela thread atual
+/// @param func Função a executar
+/// @param count Tamanho do intervalo
+/// @param data Parâmetro repassado para 'func'
+void runParallel(ThreadPool *pool, ParallelFunc func, int count, void *data);
+
+/// Encerra as threads de um grupo e libera a memória usada por ele
+///
+/// @param pool Grupo a ser deletado
+void freeThreadPool(ThreadPool *pool);
+
+#endif
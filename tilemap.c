@@ -0,0 +1,93 @@
+#include <math.h>
+#include "tilemap.h"
+
+TileMap *newTileMap(Point origin, Point tileSize, int columns, int lines)
+{
+	TileMap *map = (TileMap *)taggedMalloc(sizeof(*map), MEMORY_PHYSICS);
+	map->columns = columns;
+	map->lines = lines;
+	map->wordsPerLine = (columns + 31) / 32;
+	map->solid = (Uint32 *)taggedMalloc(map->wordsPerLine * lines * sizeof(Uint32), MEMORY_PHYSICS);
+	memset(map->solid, 0, map->wordsPerLine * lines * sizeof(Uint32));
+	map->origin = origin;
+	map->tileSize = tileSize;
+	map->version = 0;
+	map->tile = newObject(origin, newPoint(columns * tileSize.x, lines * tileSize.y), newPoint(0, 0), NULL);
+	return map;
+}
+
+void setTileSolid(TileMap *map, int column, int line, bool solid)
+{
+	if (column < 0 || column >= map->columns || line < 0 || line >= map->lines) return;
+	Uint32 *word = &map->solid[line * map->wordsPerLine + column / 32];
+	if (solid) *word |= 1u << (column % 32);
+	else *word &= ~(1u << (column % 32));
+	map->version++;
+}
+
+void resizeTileMap(TileMap *map, Point origin, int columns, int lines)
+{
+	int words = (columns + 31) / 32;
+	if (words * lines > map->wordsPerLine * map->lines)
+	{
+		taggedFree(map->solid);
+		map->solid = (Uint32 *)taggedMalloc(words * lines * sizeof(Uint32), MEMORY_PHYSICS);
+	}
+	map->columns = columns;
+	map->lines = lines;
+	map->wordsPerLine = words;
+	memset(map->solid, 0, words * lines * sizeof(Uint32));
+	map->origin = origin;
+	map->tile->bounds = newRectangle(origin.x, origin.y, columns * map->tileSize.x, lines * map->tileSize.y);
+	map->version++;
+}
+
+bool isTileSolid(TileMap *map, int column, int line)
+{
+	if (column < 0 || column >= map->columns || line < 0 || line >= map->lines) return false;
+	return (map->solid[line * map->wordsPerLine + column / 32] >> (column % 32)) & 1;
+}
+
+Rectangle getTileBounds(TileMap *map, int column, int line)
+{
+	return newRectangle(map->origin.x + column * map->tileSize.x, map->origin.y + line * map->tileSize.y,
+		map->tileSize.x, map->tileSize.y);
+}
+
+void forEachSolidTile(TileMap *map, Rectangle area, bool (*func)(Rectangle, void *), void *data)
+{
+	// Faixa de células tocadas pela área; as bordas são testadas com intersects, como qualquer outro obstáculo
+	int col0 = (int)floorf((area.position.x - map->origin.x) / map->tileSize.x),
+		col1 = (int)floorf((area.position.x + area.size.x - map->origin.x) / map->tileSize.x),
+		line0 = (int)floorf((area.position.y - map->origin.y) / map->tileSize.y),
+		line1 = (int)floorf((area.position.y + area.size.y - map->origin.y) / map->tileSize.y),
+		line, w;
+	if (col0 < 0) col0 = 0;
+	if (line0 < 0) line0 = 0;
+	if (col1 >= map->columns) col1 = map->columns - 1;
+	if (line1 >= map->lines) line1 = map->lines - 1;
+	if (col0 > col1) return;
+
+	for (line = line0; line <= line1; line++)
+	{
+		Uint32 *row = &map->solid[line * map->wordsPerLine];
+		for (w = col0 / 32; w <= col1 / 32; w++)
+		{
+			Uint32 bits = row[w];
+			if (w == col0 / 32) bits &= ~0u << (col0 % 32);
+			if (w == col1 / 32 && col1 % 32 != 31) bits &= (1u << (col1 % 32 + 1)) - 1;
+			for (; bits; bits &= bits - 1)
+			{
+				Rectangle r = getTileBounds(map, w * 32 + __builtin_ctz(bits), line);
+				if (intersects(r, area) && !func(r, data)) return;
+			}
+		}
+	}
+}
+
+void freeTileMap(TileMap *map)
+{
+	freeObject(map->tile);
+	taggedFree(map->solid);
+	taggedFree(map);
+}
@@ -0,0 +1,89 @@
+/** @file */
+
+#ifndef MINI_TILEMAP_H
+#define MINI_TILEMAP_H
+
+#include "object.h"
+
+/// Grade de colisão para a geometria fixa de uma fase, em que cada célula é sólida ou vazia. A solidez é guardada como um vetor de bits, uma linha da grade após a outra
+typedef struct {
+	/// Bits de solidez das células. A linha l ocupa as posições [l * wordsPerLine, (l + 1) * wordsPerLine)
+	Uint32 *solid;
+
+	/// Quantidade de colunas da grade
+	int columns;
+
+	/// Quantidade de linhas da grade
+	int lines;
+
+	/// Quantidade de posições de 'solid' usadas por linha da grade
+	int wordsPerLine;
+
+	/// Posição do canto superior esquerdo da grade
+	Point origin;
+
+	/// Largura (tileSize.x) e altura (tileSize.y) de cada célula
+	Point tileSize;
+
+	/// Objeto que representa as células sólidas nos campos top, right, bottom e left das partículas que colidem com a grade. Seus limites cobrem a grade inteira
+	Object *tile;
+
+	/// Contador de alterações na solidez das células, incrementado por setTileSolid
+	int version;
+} TileMap;
+
+/// Cria uma grade de colisão com todas as células vazias
+///
+/// @param origin Posição do canto superior esquerdo da grade
+/// @param tileSize Largura e altura de cada célula
+/// @param columns Quantidade de colunas
+/// @param lines Quantidade de linhas
+/// @return A grade gerada
+TileMap *newTileMap(Point origin, Point tileSize, int columns, int lines);
+
+/// Define se uma célula da grade é sólida
+///
+/// @param map Grade a ser alterada
+/// @param column Coluna da célula
+/// @param line Linha da célula
+/// @param solid Verdadeiro para sólida, falso para vazia
+void setTileSolid(TileMap *map, int column, int line, bool solid);
+
+/// Retorna se uma célula da grade é sólida. Células fora da grade são consideradas vazias
+///
+/// @param map Grade a ser consultada
+/// @param column Coluna da célula
+/// @param line Linha da célula
+/// @return Verdadeiro se a célula é sólida
+bool isTileSolid(TileMap *map, int column, int line);
+
+/// Retorna a área ocupada por uma célula da grade
+///
+/// @param map Grade a ser consultada
+/// @param column Coluna da célula
+/// @param line Linha da célula
+/// @return Retângulo da célula
+Rectangle getTileBounds(TileMap *map, int column, int line);
+
+/// Chama uma função para cada célula sólida que intercepta uma área, linha por linha, da esquerda para a direita
+///
+/// @param map Grade a ser percorrida
+/// @param area Área a ser considerada
+/// @param func Função chamada com o retângulo de cada célula sólida e o parâmetro 'data'. Se retornar falso, o percurso é interrompido
+/// @param data Parâmetro repassado para 'func'
+void forEachSolidTile(TileMap *map, Rectangle area, bool (*func)(Rectangle, void *), void *data);
+
+/// Move e redimensiona uma grade de colisão, deixando todas as células vazias. O objeto 'tile' continua o mesmo, com limites cobrindo a nova área, de modo que a grade pode acompanhar a área carregada de uma fase sem ser recriada
+///
+/// @param map Grade a ser alterada
+/// @param origin Nova posição do canto superior esquerdo da grade
+/// @param columns Nova quantidade de colunas
+/// @param lines Nova quantidade de linhas
+void resizeTileMap(TileMap *map, Point origin, int columns, int lines);
+
+/// Libera a memória usada por uma grade de colisão
+///
+/// @param map Grade a ser deletada
+void freeTileMap(TileMap *map);
+
+#endif
@@ -0,0 +1,90 @@
+// Banco de testes do áudio sem dispositivo de som: abre o mixer com buffers de tamanhos diferentes no driver
+// nulo ('dummy') ou no de arquivo ('disk'), toca sons como um jogo faria a cada frame e mostra as medidas do
+// mixer (ver getAudioStats), para escolher o menor buffer que não causa falhas
+//
+// Uso: audiobench [driver] [segundos]
+
+#include <stdlib.h>
+#include <math.h>
+#include "../control.h"
+
+#define NUM_TONES 8
+
+static const int bufferSizes[] = {256, 512, 1024, 2048, 4096};
+static char driverVariable[64], diskDelayVariable[64], driverName[32];
+
+Sound *newTone(float frequency, int length)
+{
+	// O mixer é aberto com MIX_DEFAULT_FORMAT, ou seja, amostras de 16 bits no formato da máquina
+	int rate, channels, i, c;
+	Uint16 format;
+	Mix_QuerySpec(&rate, &format, &channels);
+	Sint16 *samples = (Sint16 *)malloc(length * channels * sizeof(Sint16));
+	for (i = 0; i < length; i++)
+		for (c = 0; c < channels; c++)
+			samples[i * channels + c] = 8000 * sinf(2 * M_PI * frequency * i / rate) * (length - i) / length;
+	return Mix_QuickLoad_RAW((Uint8 *)samples, length * channels * sizeof(Sint16));
+}
+
+int main(int argc, char **argv)
+{
+	const char *driver = argc > 1 ? argv[1] : "dummy";
+	int seconds = argc > 2 ? atoi(argv[2]) : 2;
+	snprintf(driverVariable, sizeof(driverVariable), "SDL_AUDIODRIVER=%s", driver);
+	SDL_putenv(driverVariable);
+	SDL_putenv("SDL_DISKAUDIOFILE=/dev/null");
+	if (SDL_Init(SDL_INIT_AUDIO) < 0)
+	{
+		printf("Erro ao iniciar o SDL: %s\n", SDL_GetError());
+		return 1;
+	}
+
+	printf("buffer  período(us)  misturas  falhas  maior intervalo(us)  callback médio/máximo(us)  vozes\n");
+	int b, t;
+	for (b = 0; b < (int)(sizeof(bufferSizes) / sizeof(bufferSizes[0])); b++)
+	{
+		AudioSettings settings = getDefaultAudioSettings();
+		settings.bufferSize = bufferSizes[b];
+
+		// O driver de arquivo espera um tempo fixo entre buffers, que deve ser a duração de cada um
+		snprintf(diskDelayVariable, sizeof(diskDelayVariable), "SDL_DISKAUDIODELAY=%d", settings.bufferSize * 1000 / settings.frequency);
+		SDL_putenv(diskDelayVariable);
+		initializeAudioSettings(settings);
+		if (SDL_AudioDriverName(driverName, sizeof(driverName)) == NULL) return 1;
+
+		Sound *tones[NUM_TONES];
+		for (t = 0; t < NUM_TONES; t++)
+			tones[t] = newTone(220 * (t + 1), settings.frequency / 4);
+
+		// Cada frame de cerca de 16 ms toca alguns sons com prioridades e posições variadas, como num jogo
+		Uint64 start = getMicroseconds(), next = start;
+		int frame = 0;
+		resetAudioStats();
+		while (getMicroseconds() - start < (Uint64)seconds * 1000000)
+		{
+			clearRecentSounds();
+			for (t = 0; t < 1 + frame % 4; t++)
+				playSoundVoice(tones[(frame + t) % NUM_TONES], 0.5, (t % 3) - 1, (frame + t) % SOUND_PRIORITIES);
+			frame++;
+			next += 16667;
+			Uint64 now = getMicroseconds();
+			if (next > now) SDL_Delay((next - now) / 1000);
+		}
+
+		AudioStats stats = getAudioStats();
+		printf("%6d  %11u  %8d  %6d  %19u  %12u/%-12u  %d/%d\n", settings.bufferSize, stats.period, stats.callbacks, stats.underruns,
+			stats.maxInterval, stats.averageCallbackTime, stats.maxCallbackTime, stats.activeVoices, stats.maxActiveVoices);
+
+		setSoundVoices(SOUND_CHANNELS);
+		for (t = 0; t < NUM_TONES; t++)
+		{
+			free(tones[t]->abuf);
+			Mix_FreeChunk(tones[t]);
+		}
+	}
+	printf("driver: %s\n", driverName);
+
+	Mix_CloseAudio();
+	SDL_Quit();
+	return 0;
+}
@@ -0,0 +1,191 @@
+// Gerador de fases: lê a descrição de uma fase em texto e grava o arquivo binário dividido em setores,
+// que pode ser carregado com loadLevel
+//
+// Uso: levelbuilder <fase> <descrição>
+//
+// A descrição é uma sequência de comandos:
+//   size <colunas> <linhas> <largura da célula> <altura da célula> <lado dos setores, em células>
+//   tileset <imagem> <colunas> <linhas>
+//   solid     seguido de <linhas> linhas de texto, com '#' nas células sólidas
+//   layer     seguido de <colunas> * <linhas> números: 0 para células vazias e i + 1 para a imagem i do tileset
+//   object <tipo> <x> <y> <largura> <altura> <valor adicional>
+// O comando size deve vir antes dos demais
+
+#include <stdlib.h>
+#include "../level.h"
+
+typedef struct {
+	LevelObjectInfo info;
+	int sector, order;
+} Item;
+
+int compareItems(const void *a, const void *b)
+{
+	// Ordena pelo setor, mantendo a ordem da descrição dentro de cada setor
+	const Item *x = (const Item *)a, *y = (const Item *)b;
+	if (x->sector != y->sector) return x->sector - y->sector;
+	return x->order - y->order;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 3)
+	{
+		printf("Uso: %s <fase> <descrição>\n", argv[0]);
+		return 1;
+	}
+	FILE *in = fopen(argv[2], "r");
+	if (!in)
+	{
+		printf("Erro ao abrir %s\n", argv[2]);
+		return 1;
+	}
+
+	LevelHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, LEVEL_MAGIC, 4);
+	header.version = LEVEL_VERSION;
+	Uint8 *solid = NULL;
+	Uint16 *layers = NULL;
+	Item *items = NULL;
+	int numItems = 0, itemsCapacity = 0, columns = 0, lines = 0, i, j;
+	char command[16], line[LEVEL_PATH_SIZE + 1];
+	while (fscanf(in, "%15s", command) == 1)
+	{
+		if (strcmp(command, "size") == 0)
+		{
+			if (fscanf(in, "%d %d %f %f %u", &columns, &lines, &header.tileSize.x, &header.tileSize.y, &header.sectorSize) != 5 ||
+				columns <= 0 || lines <= 0 || header.sectorSize == 0)
+				break;
+			header.columns = columns;
+			header.lines = lines;
+			solid = (Uint8 *)calloc(columns * lines, 1);
+		}
+		else if (!solid) break;
+		else if (strcmp(command, "tileset") == 0)
+		{
+			if (fscanf(in, "%64s %u %u", line, &header.tilesetColumns, &header.tilesetLines) != 3 || strlen(line) >= LEVEL_PATH_SIZE) break;
+			strcpy(header.tileset, line);
+		}
+		else if (strcmp(command, "solid") == 0)
+		{
+			int c = fgetc(in);
+			while (c != '\n' && c != EOF)
+				c = fgetc(in);
+			for (j = 0; j < lines; j++)
+				for (i = 0; (c = fgetc(in)) != '\n' && c != EOF; i++)
+					if (i < columns) solid[i + j * columns] = c == '#';
+		}
+		else if (strcmp(command, "layer") == 0)
+		{
+			layers = (Uint16 *)realloc(layers, (header.layers + 1) * columns * lines * sizeof(Uint16));
+			Uint16 *cells = layers + header.layers * columns * lines;
+			for (i = 0; i < columns * lines; i++)
+			{
+				unsigned cell;
+				if (fscanf(in, "%u", &cell) != 1) break;
+				cells[i] = cell;
+			}
+			if (i < columns * lines) break;
+			header.layers++;
+		}
+		else if (strcmp(command, "object") == 0)
+		{
+			if (numItems == itemsCapacity)
+			{
+				itemsCapacity = itemsCapacity > 0 ? 2 * itemsCapacity : 64;
+				items = (Item *)realloc(items, itemsCapacity * sizeof(Item));
+			}
+			LevelObjectInfo *info = &items[numItems].info;
+			if (fscanf(in, "%u %f %f %f %f %d", &info->type, &info->position.x, &info->position.y, &info->size.x, &info->size.y, &info->param) != 6)
+				break;
+			numItems++;
+		}
+		else break;
+	}
+	if (!feof(in) || !solid || (header.layers > 0 && header.tilesetColumns * header.tilesetLines == 0))
+	{
+		printf("Descrição inválida: %s (comando %s)\n", argv[2], command);
+		return 1;
+	}
+	fclose(in);
+
+	// Cada objeto pertence ao setor onde começa
+	int size = header.sectorSize;
+	header.sectorColumns = (columns + size - 1) / size;
+	header.sectorLines = (lines + size - 1) / size;
+	int numSectors = header.sectorColumns * header.sectorLines;
+	for (i = 0; i < numItems; i++)
+	{
+		int column = (int)(items[i].info.position.x / (size * header.tileSize.x)), line = (int)(items[i].info.position.y / (size * header.tileSize.y));
+		if (column < 0) column = 0;
+		if (line < 0) line = 0;
+		if (column >= (int)header.sectorColumns) column = header.sectorColumns - 1;
+		if (line >= (int)header.sectorLines) line = header.sectorLines - 1;
+		items[i].sector = column + line * header.sectorColumns;
+		items[i].order = i;
+	}
+	qsort(items, numItems, sizeof(Item), compareItems);
+
+	// Monta os dados de cada setor: solidez, camadas e objetos. Setores sem nada não ocupam espaço no arquivo
+	int words = (size + 31) / 32, tileBytes = (size * words * sizeof(Uint32) + header.layers * size * size * sizeof(Uint16) + 3) & ~3;
+	LevelSector *sectors = (LevelSector *)calloc(numSectors, sizeof(LevelSector));
+	Uint8 *buffer = (Uint8 *)malloc(tileBytes);
+	FILE *out = fopen(argv[1], "wb");
+	if (!out)
+	{
+		printf("Erro ao criar %s\n", argv[1]);
+		return 1;
+	}
+	fwrite(&header, sizeof(header), 1, out);
+	fwrite(sectors, sizeof(LevelSector), numSectors, out);
+	static const Uint8 padding[LEVEL_SECTOR_ALIGN];
+	int sector, item = 0, used = 0, layer;
+	for (sector = 0; sector < numSectors; sector++)
+	{
+		int firstColumn = (sector % header.sectorColumns) * size, firstLine = (sector / header.sectorColumns) * size;
+		bool empty = true;
+		memset(buffer, 0, tileBytes);
+		Uint32 *bits = (Uint32 *)buffer;
+		Uint16 *cells = (Uint16 *)(buffer + size * words * sizeof(Uint32));
+		for (j = 0; j < size && firstLine + j < lines; j++)
+			for (i = 0; i < size && firstColumn + i < columns; i++)
+			{
+				int cell = firstColumn + i + (firstLine + j) * columns;
+				if (solid[cell])
+				{
+					bits[j * words + i / 32] |= 1u << (i % 32);
+					empty = false;
+				}
+				for (layer = 0; layer < (int)header.layers; layer++)
+				{
+					cells[layer * size * size + i + j * size] = layers[layer * columns * lines + cell];
+					if (layers[layer * columns * lines + cell]) empty = false;
+				}
+			}
+		int first = item;
+		while (item < numItems && items[item].sector == sector)
+			item++;
+		if (empty && item == first) continue;
+
+		fwrite(padding, 1, (LEVEL_SECTOR_ALIGN - ftell(out) % LEVEL_SECTOR_ALIGN) % LEVEL_SECTOR_ALIGN, out);
+		sectors[sector].offset = ftell(out);
+		sectors[sector].objects = item - first;
+		fwrite(buffer, 1, tileBytes, out);
+		for (i = first; i < item; i++)
+			fwrite(&items[i].info, sizeof(LevelObjectInfo), 1, out);
+		used++;
+	}
+	fseek(out, sizeof(header), SEEK_SET);
+	fwrite(sectors, sizeof(LevelSector), numSectors, out);
+	fclose(out);
+	printf("Fase gravada em %s: %d x %d células, %d de %d setores ocupados, %d camadas, %d objetos\n",
+		argv[1], columns, lines, used, numSectors, header.layers, numItems);
+
+	free(solid);
+	free(layers);
+	free(items);
+	free(sectors);
+	free(buffer);
+	return 0;
+}
@@ -0,0 +1,123 @@
+// Banco de testes da física: monta sempre a mesma cena (partículas caindo sobre plataformas e um chão de células) e
+// mede o tempo por frame de stepPhysics com quantidades crescentes de threads (ver setPhysicsThreads). Também confere
+// que o resultado final é idêntico para todas as quantidades de threads
+//
+// Uso: physicsbench [partículas] [frames] [máximo de threads]
+
+#include <stdlib.h>
+#include <unistd.h>
+#include "../world.h"
+
+#define NUM_PLATFORMS 200
+
+typedef struct {
+	World *world;
+	TileMap *tiles;
+	Particle **particles;
+	Object **platforms;
+	int numParticles;
+} Scene;
+
+Scene newScene(int numParticles)
+{
+	// A semente é fixa, para que todas as medidas usem exatamente a mesma cena
+	Scene scene;
+	Random rng;
+	seedRandom(&rng, 1);
+	int i;
+	float width = 4000, height = 3000;
+	scene.world = newWorld();
+	scene.tiles = newTileMap(newPoint(0, 0), newPoint(16, 16), width / 16, height / 16 + 1);
+	for (i = 0; i < scene.tiles->columns; i++)
+		setTileSolid(scene.tiles, i, scene.tiles->lines - 1, true);
+	setWorldTiles(scene.world, scene.tiles);
+	scene.platforms = (Object **)malloc(NUM_PLATFORMS * sizeof(Object *));
+	for (i = 0; i < NUM_PLATFORMS; i++)
+	{
+		Point pos = newPoint(randomFloat(&rng, 0, width - 100), randomFloat(&rng, 500, height - 100));
+		scene.platforms[i] = newObject(pos, newPoint(randomFloat(&rng, 40, 100), 10), newPoint(0, 0), NULL);
+		addObstacleToWorld(scene.world, scene.platforms[i]);
+	}
+	scene.numParticles = numParticles;
+	scene.particles = (Particle **)malloc(numParticles * sizeof(Particle *));
+	for (i = 0; i < numParticles; i++)
+	{
+		Point pos = newPoint(randomFloat(&rng, 0, width - 8), randomFloat(&rng, 0, height - 200));
+		scene.particles[i] = newParticle(newObject(pos, newPoint(8, 8), newPoint(0, 0), NULL), 10, 1);
+		setSpeed(scene.particles[i], randomFloat(&rng, -2, 2), randomFloat(&rng, -2, 2));
+		addParticleToWorld(scene.world, scene.particles[i]);
+	}
+	return scene;
+}
+
+void stepScene(Scene *scene)
+{
+	int i;
+	for (i = 0; i < scene->numParticles; i++)
+		setForces(scene->particles[i], 0, 0.3f);
+	stepPhysics(scene->world);
+}
+
+Uint64 hashScene(Scene *scene)
+{
+	// Combina as posições e velocidades finais bit a bit (FNV-1a), para comparar os resultados das várias execuções
+	Uint64 hash = 14695981039346656037ull;
+	int i, j;
+	for (i = 0; i < scene->numParticles; i++)
+	{
+		Particle *part = scene->particles[i];
+		float values[4] = {part->obj->bounds.position.x, part->obj->bounds.position.y, part->speed.x, part->speed.y};
+		Uint8 *bytes = (Uint8 *)values;
+		for (j = 0; j < (int)sizeof(values); j++)
+			hash = (hash ^ bytes[j]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+void freeScene(Scene *scene)
+{
+	int i;
+	freeWorld(scene->world);
+	for (i = 0; i < scene->numParticles; i++)
+		freeParticle(scene->particles[i]);
+	for (i = 0; i < NUM_PLATFORMS; i++)
+		freeObject(scene->platforms[i]);
+	freeTileMap(scene->tiles);
+	free(scene->particles);
+	free(scene->platforms);
+}
+
+int main(int argc, char **argv)
+{
+	int numParticles = argc > 1 ? atoi(argv[1]) : 5000, frames = argc > 2 ? atoi(argv[2]) : 300,
+		maxThreads = argc > 3 ? atoi(argv[3]) : sysconf(_SC_NPROCESSORS_ONLN);
+	if (numParticles <= 0 || frames <= 0 || maxThreads <= 0)
+	{
+		printf("Uso: %s [partículas] [frames] [máximo de threads]\n", argv[0]);
+		return 1;
+	}
+
+	printf("%d partículas, %d obstáculos, %d frames\n", numParticles, NUM_PLATFORMS, frames);
+	printf("threads  ms/frame  aceleração  resultado\n");
+	double baseline = 0;
+	Uint64 expected = 0;
+	int threads, f;
+	for (threads = 1; threads <= maxThreads; threads++)
+	{
+		Scene scene = newScene(numParticles);
+		setPhysicsThreads(scene.world, threads);
+		Uint64 start = getMicroseconds();
+		for (f = 0; f < frames; f++)
+			stepScene(&scene);
+		double ms = (getMicroseconds() - start) / 1000.0 / frames;
+		Uint64 hash = hashScene(&scene);
+		if (threads == 1)
+		{
+			baseline = ms;
+			expected = hash;
+		}
+		printf("%7d  %8.3f  %9.2fx  %s\n", threads, ms, baseline / ms, hash == expected ? "igual" : "DIFERENTE");
+		freeScene(&scene);
+	}
+	return 0;
+}
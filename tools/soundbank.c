@@ -0,0 +1,104 @@
+// Conversor de bancos de sons: decodifica arquivos de som com o SDL_mixer, no formato de saída em que o jogo abre o mixer,
+// e grava as amostras em sequência num único arquivo, que pode ser carregado com loadSoundBank
+//
+// Uso: soundbank <banco> <frequência> <canais> <arquivo>...
+
+#include <stdlib.h>
+#include "../soundbank.h"
+
+typedef struct {
+	SoundBankEntry entry;
+	Mix_Chunk *chunk;
+} Item;
+
+int compareItems(const void *a, const void *b)
+{
+	return strncmp(((Item *)a)->entry.name, ((Item *)b)->entry.name, SOUND_BANK_NAME_SIZE);
+}
+
+int main(int argc, char **argv)
+{
+	if (argc < 5)
+	{
+		printf("Uso: %s <banco> <frequência> <canais> <arquivo>...\n", argv[0]);
+		return 1;
+	}
+
+	// O driver de áudio nulo permite usar a conversão do SDL_mixer sem dispositivo de som
+	SDL_putenv("SDL_AUDIODRIVER=dummy");
+	if (SDL_Init(SDL_INIT_AUDIO) < 0 || Mix_OpenAudio(atoi(argv[2]), MIX_DEFAULT_FORMAT, atoi(argv[3]), 4096) < 0)
+	{
+		printf("Erro ao iniciar o áudio: %s\n", SDL_GetError());
+		return 1;
+	}
+	SoundBankHeader header;
+	int frequency, channels;
+	memcpy(header.magic, SOUND_BANK_MAGIC, 4);
+	header.version = SOUND_BANK_VERSION;
+	Mix_QuerySpec(&frequency, &header.format, &channels);
+	header.frequency = frequency;
+	header.channels = channels;
+	header.count = argc - 4;
+
+	Item *items = (Item *)calloc(header.count, sizeof(Item));
+	int i;
+	for (i = 0; i < (int)header.count; i++)
+	{
+		const char *path = argv[i + 4], *base = strrchr(path, '/');
+		base = base ? base + 1 : path;
+		const char *dot = strrchr(base, '.');
+		int length = dot ? dot - base : (int)strlen(base);
+		if (length >= SOUND_BANK_NAME_SIZE)
+		{
+			printf("Nome longo demais: %s\n", base);
+			return 1;
+		}
+		memcpy(items[i].entry.name, base, length);
+		items[i].chunk = Mix_LoadWAV(path);
+		if (!items[i].chunk)
+		{
+			printf("Erro ao carregar %s: %s\n", path, Mix_GetError());
+			return 1;
+		}
+		items[i].entry.length = items[i].chunk->alen;
+	}
+
+	// As entradas ficam ordenadas pelo nome, para a busca binária de getBankSound
+	qsort(items, header.count, sizeof(Item), compareItems);
+	Uint32 offset = sizeof(SoundBankHeader) + header.count * sizeof(SoundBankEntry);
+	for (i = 0; i < (int)header.count; i++)
+	{
+		if (i > 0 && compareItems(&items[i - 1], &items[i]) == 0)
+		{
+			printf("Nome repetido: %s\n", items[i].entry.name);
+			return 1;
+		}
+		offset = (offset + SOUND_BANK_ALIGN - 1) & ~(SOUND_BANK_ALIGN - 1);
+		items[i].entry.offset = offset;
+		offset += items[i].entry.length;
+	}
+
+	FILE *out = fopen(argv[1], "wb");
+	if (!out)
+	{
+		printf("Erro ao criar %s\n", argv[1]);
+		return 1;
+	}
+	fwrite(&header, sizeof(header), 1, out);
+	for (i = 0; i < (int)header.count; i++)
+		fwrite(&items[i].entry, sizeof(SoundBankEntry), 1, out);
+	static const Uint8 padding[SOUND_BANK_ALIGN];
+	for (i = 0; i < (int)header.count; i++)
+	{
+		fwrite(padding, 1, items[i].entry.offset - ftell(out), out);
+		fwrite(items[i].chunk->abuf, 1, items[i].entry.length, out);
+		Mix_FreeChunk(items[i].chunk);
+	}
+	fclose(out);
+	printf("%d sons gravados em %s (%d Hz, %d canais)\n", header.count, argv[1], header.frequency, header.channels);
+
+	free(items);
+	Mix_CloseAudio();
+	SDL_Quit();
+	return 0;
+}
@@ -0,0 +1,1023 @@
+#include "world.h"
+
+// Estado de um objeto e de sua partícula guardado num instantâneo (WorldSnapshot)
+typedef struct {
+	Rectangle bounds;
+	Point speed;
+	Object *contacts[4];
+	byte imgIndex, imgTimer, animIndex;
+	bool sleeping;
+} ObjectState;
+
+void addBody(World *world, Object *obj, Particle *part);
+void *growArray(void *array, int count, int newCount, size_t itemSize);
+void resizeThreadBuffers(World *world);
+void updateAreas(int first, int last, int thread, void *data);
+void sortBodies(World *world);
+void findPairs(int first, int last, int thread, void *data);
+void findCandidates(World *world);
+void sortCandidates(int first, int last, int thread, void *data);
+void findContacts(int first, int last, int thread, void *data);
+int gatherCandidates(World *world, int body, Object **scratch);
+bool reuseContacts(World *world, int body, Object **scratch);
+int findContactBody(World *world, int body, Object *obj);
+void addContactEvents(World *world, int body);
+void wakeIsland(World *world, int body);
+void listBody(World *world, int body, int *count);
+int findIsland(World *world, int body);
+void updateIslands(World *world);
+bool touches(Rectangle a, Rectangle b);
+void buildQueryGrid(World *world);
+void checkQueryGrid(World *world);
+void getCellRange(World *world, Rectangle area, int *col0, int *line0, int *col1, int *line1);
+bool clipSegment(Rectangle rect, Point from, Point delta, float *enter, float *exit);
+float castRayTiles(TileMap *map, Point from, Point delta);
+
+static inline bool collidesWith(Body *a, Body *b)
+{
+	return a->part && !a->asleep && (a->obj->collisionMask & b->obj->category);
+}
+
+World *newWorld()
+{
+	World *world = (World *)taggedMalloc(sizeof(*world), MEMORY_PHYSICS);
+	world->bodies = NULL;
+	world->size = world->capacity = 0;
+	world->order = NULL;
+	world->pairs = NULL;
+	world->numPairs = NULL;
+	world->pairsCapacity = 256;
+	world->candidateStart = NULL;
+	world->candidates = NULL;
+	world->candidatesCapacity = 0;
+	world->previousStart = NULL;
+	world->previousCandidates = NULL;
+	world->previousCapacity = 0;
+	world->previousValid = false;
+	world->awake = NULL;
+	world->numAwake = 0;
+	world->parents = NULL;
+	world->sleepSpeed = 0.01f;
+	world->sleepFrames = 30;
+	world->continuous = false;
+	world->events = NULL;
+	world->numEvents = world->eventsCapacity = 0;
+	world->contactTiles = NULL;
+	world->contactTilesVersion = 0;
+	world->rescan = true;
+	world->scratch = NULL;
+	world->threads = NULL;
+	world->tiles = NULL;
+	world->cellStart = world->cellBodies = NULL;
+	world->cellsCapacity = world->cellBodiesCapacity = 0;
+	world->gridDirty = true;
+	resizeThreadBuffers(world);
+	return world;
+}
+
+void addParticleToWorld(World *world, Particle *part)
+{
+	addBody(world, part->obj, part);
+}
+
+void addObstacleToWorld(World *world, Object *obj)
+{
+	addBody(world, obj, NULL);
+}
+
+void removeFromWorld(World *world, Object *obj)
+{
+	int i, removed = -1;
+	for (i = 0; i < world->size; i++)
+		if (world->bodies[i].obj == obj)
+		{
+			removed = i;
+			break;
+		}
+	if (removed < 0) return;
+
+	// As partículas dormindo que tocavam o corpo removido podem ter perdido o apoio
+	Rectangle bounds = getBounds(obj);
+	for (i = 0; i < world->size; i++)
+		if (world->bodies[i].asleep && (i == removed || touches(getBounds(world->bodies[i].obj), bounds)))
+			wakeIsland(world, i);
+
+	// Mantém a ordem de inserção dos demais corpos, da qual depende a ordem de movimentação
+	memmove(&world->bodies[removed], &world->bodies[removed + 1], (world->size - removed - 1) * sizeof(Body));
+	int j = 0;
+	for (i = 0; i < world->size; i++)
+		if (world->order[i] != removed)
+			world->order[j++] = world->order[i] > removed ? world->order[i] - 1 : world->order[i];
+	world->size--;
+	world->gridDirty = true;
+	world->previousValid = false;
+	for (i = 0; i < world->size; i++)
+	{
+		Body *b = &world->bodies[i];
+		world->parents[i] = i;
+		if (b->island > removed) b->island--;
+
+		// Um contato removido obriga a recalcular os contatos da partícula
+		for (j = 0; j < 4; j++)
+			if (b->contactBodies[j] == removed)
+			{
+				b->contactBodies[j] = -1;
+				b->cached = false;
+			}
+			else if (b->contactBodies[j] > removed) b->contactBodies[j]--;
+	}
+}
+
+void setWorldTiles(World *world, TileMap *tiles)
+{
+	world->tiles = tiles;
+}
+
+void setWorldSleep(World *world, float speed, int frames)
+{
+	world->sleepSpeed = speed;
+	world->sleepFrames = frames;
+	if (frames > 0) return;
+
+	int i;
+	for (i = 0; i < world->size; i++)
+		if (world->bodies[i].asleep) wakeIsland(world, i);
+}
+
+void setWorldContinuous(World *world, bool continuous)
+{
+	world->continuous = continuous;
+}
+
+void setPhysicsThreads(World *world, int threads)
+{
+	if (threads == getThreadCount(world->threads)) return;
+	if (world->threads) freeThreadPool(world->threads);
+	world->threads = threads > 1 ? newThreadPool(threads) : NULL;
+	resizeThreadBuffers(world);
+}
+
+void stepPhysics(World *world)
+{
+	int threads = getThreadCount(world->threads), i;
+
+	// setSpeed, setForces e wakeParticle apenas marcam a partícula; a ilha inteira é acordada aqui
+	for (i = 0; i < world->size; i++)
+		if (world->bodies[i].asleep && !world->bodies[i].part->sleeping)
+			wakeIsland(world, i);
+
+	world->numAwake = 0;
+	for (i = 0; i < world->size; i++)
+		if (world->bodies[i].part && !world->bodies[i].asleep)
+			world->awake[world->numAwake++] = i;
+	world->numEvents = 0;
+	if (world->numAwake == 0)
+	{
+		checkQueryGrid(world);
+		return;
+	}
+
+	// Uma alteração na grade de colisão pode desfazer qualquer contato guardado
+	world->rescan = world->tiles != world->contactTiles || (world->tiles && world->tiles->version != world->contactTilesVersion);
+	world->contactTiles = world->tiles;
+	world->contactTilesVersion = world->tiles ? world->tiles->version : 0;
+
+	runParallel(world->threads, updateAreas, world->size, world);
+	sortBodies(world);
+
+	// Cada thread guarda seus pares num vetor próprio; se algum encher, todos crescem e a busca é refeita
+	bool full;
+	do
+	{
+		runParallel(world->threads, findPairs, world->size, world);
+		full = false;
+		for (i = 0; i < threads; i++)
+			if (world->numPairs[i] > world->pairsCapacity)
+			{
+				world->pairsCapacity = 2 * world->numPairs[i];
+				full = true;
+			}
+		if (full) resizeThreadBuffers(world);
+	} while (full);
+
+	findCandidates(world);
+	runParallel(world->threads, findContacts, world->numAwake, world);
+
+	for (i = 0; i < world->numAwake; i++)
+	{
+		int body = world->awake[i];
+		int count = gatherCandidates(world, body, world->scratch);
+		if (world->continuous) resolveSweptMovement(world->bodies[body].part, world->scratch, count, world->tiles);
+		else resolveParticleMovement(world->bodies[body].part, world->scratch, count, world->tiles);
+		addContactEvents(world, body);
+	}
+
+	if (world->sleepFrames > 0) updateIslands(world);
+	checkQueryGrid(world);
+}
+
+int queryRegion(World *world, Rectangle area, Uint32 mask, Object **results, int max)
+{
+	if (world->gridDirty) buildQueryGrid(world);
+	int col0, line0, col1, line1, col, line, i, count = 0;
+	getCellRange(world, area, &col0, &line0, &col1, &line1);
+	for (line = line0; line <= line1; line++)
+		for (col = col0; col <= col1; col++)
+		{
+			int cell = col + line * world->gridColumns;
+			for (i = world->cellStart[cell]; i < world->cellStart[cell + 1]; i++)
+			{
+				Body *b = &world->bodies[world->cellBodies[i]];
+				if (!(b->obj->category & mask) || !intersects(b->queryBounds, area)) continue;
+
+				// Um corpo que ocupa várias células é contado apenas na primeira célula comum a ele e à área
+				int bodyCol0, bodyLine0, bodyCol1, bodyLine1;
+				getCellRange(world, b->queryBounds, &bodyCol0, &bodyLine0, &bodyCol1, &bodyLine1);
+				if (col != (bodyCol0 > col0 ? bodyCol0 : col0) || line != (bodyLine0 > line0 ? bodyLine0 : line0)) continue;
+				if (count < max) results[count] = b->obj;
+				count++;
+			}
+		}
+	return count;
+}
+
+int queryPoint(World *world, Point pos, Uint32 mask, Object **results, int max)
+{
+	if (world->gridDirty) buildQueryGrid(world);
+	int col, line, i, count = 0;
+	getCellRange(world, newRectangle(pos.x, pos.y, 0, 0), &col, &line, &col, &line);
+	int cell = col + line * world->gridColumns;
+	for (i = world->cellStart[cell]; i < world->cellStart[cell + 1]; i++)
+	{
+		Body *b = &world->bodies[world->cellBodies[i]];
+		Rectangle r = b->queryBounds;
+		if (!(b->obj->category & mask) ||
+			pos.x < r.position.x || pos.x >= r.position.x + r.size.x || pos.y < r.position.y || pos.y >= r.position.y + r.size.y)
+			continue;
+		if (count < max) results[count] = b->obj;
+		count++;
+	}
+	return count;
+}
+
+Object *castRay(World *world, Point from, Point to, Uint32 mask, Point *hit)
+{
+	if (world->gridDirty) buildQueryGrid(world);
+	Point delta = newPoint(to.x - from.x, to.y - from.y);
+	Object *found = NULL;
+	float best = 1, enter, exit;
+
+	// A grade de colisão é percorrida primeiro, para limitar o trecho do segmento onde os corpos são procurados
+	TileMap *map = world->tiles;
+	if (map && (map->tile->category & mask))
+	{
+		float t = castRayTiles(map, from, delta);
+		if (t <= best)
+		{
+			best = t;
+			found = map->tile;
+		}
+	}
+
+	Rectangle gridBounds = newRectangle(world->gridOrigin.x, world->gridOrigin.y,
+		world->gridColumns * world->cellSize, world->gridLines * world->cellSize);
+	if (world->size > 0 && clipSegment(gridBounds, from, delta, &enter, &exit) && enter <= best)
+	{
+		// Percorre as células atravessadas pelo segmento (algoritmo de Amanatides e Woo), a partir do ponto onde ele entra na grade
+		int col, line;
+		Point start = newPoint(from.x + delta.x * enter, from.y + delta.y * enter);
+		getCellRange(world, newRectangle(start.x, start.y, 0, 0), &col, &line, &col, &line);
+		int stepX = delta.x > 0 ? 1 : -1, stepY = delta.y > 0 ? 1 : -1;
+		float nextX = delta.x == 0 ? INFINITY : (world->gridOrigin.x + (col + (stepX > 0)) * world->cellSize - from.x) / delta.x,
+			nextY = delta.y == 0 ? INFINITY : (world->gridOrigin.y + (line + (stepY > 0)) * world->cellSize - from.y) / delta.y,
+			stepTX = delta.x == 0 ? INFINITY : world->cellSize / fabsf(delta.x),
+			stepTY = delta.y == 0 ? INFINITY : world->cellSize / fabsf(delta.y);
+		while (true)
+		{
+			int cell = col + line * world->gridColumns, i;
+			for (i = world->cellStart[cell]; i < world->cellStart[cell + 1]; i++)
+			{
+				Body *b = &world->bodies[world->cellBodies[i]];
+				Rectangle r = b->queryBounds;
+				if (!(b->obj->category & mask)) continue;
+				if (from.x >= r.position.x && from.x < r.position.x + r.size.x && from.y >= r.position.y && from.y < r.position.y + r.size.y) continue;
+				if (clipSegment(r, from, delta, &enter, &exit) && enter < best)
+				{
+					best = enter;
+					found = b->obj;
+				}
+			}
+
+			// Um impacto antes da saída da célula não pode ser superado por corpos das células seguintes
+			float cellExit = nextX < nextY ? nextX : nextY;
+			if (best <= cellExit || cellExit > 1) break;
+			if (nextX < nextY)
+			{
+				col += stepX;
+				nextX += stepTX;
+				if (col < 0 || col >= world->gridColumns) break;
+			}
+			else
+			{
+				line += stepY;
+				nextY += stepTY;
+				if (line < 0 || line >= world->gridLines) break;
+			}
+		}
+	}
+
+	if (found && hit) *hit = newPoint(from.x + delta.x * best, from.y + delta.y * best);
+	return found;
+}
+
+WorldSnapshot *newWorldSnapshot()
+{
+	WorldSnapshot *snapshot = (WorldSnapshot *)taggedMalloc(sizeof(*snapshot), MEMORY_PHYSICS);
+	snapshot->data = NULL;
+	snapshot->size = snapshot->capacity = snapshot->bodies = 0;
+	return snapshot;
+}
+
+void saveWorld(World *world, WorldSnapshot *snapshot)
+{
+	// O bloco guarda os corpos, depois o estado de cada objeto e por fim a ordem da varredura, sem ponteiros para dentro dele
+	int n = world->size, size = n * (sizeof(Body) + sizeof(ObjectState) + sizeof(int));
+	if (size > snapshot->capacity)
+	{
+		taggedFree(snapshot->data);
+		snapshot->data = taggedMalloc(size, MEMORY_PHYSICS);
+		snapshot->capacity = size;
+	}
+	snapshot->size = size;
+	snapshot->bodies = n;
+	Body *bodies = (Body *)snapshot->data;
+	ObjectState *states = (ObjectState *)(bodies + n);
+	memcpy(bodies, world->bodies, n * sizeof(Body));
+	memcpy(states + n, world->order, n * sizeof(int));
+
+	int i;
+	for (i = 0; i < n; i++)
+	{
+		Object *obj = bodies[i].obj;
+		Particle *part = bodies[i].part;
+		ObjectState *state = &states[i];
+		state->bounds = obj->bounds;
+		state->imgIndex = obj->imgIndex;
+		state->imgTimer = obj->imgTimer;
+		state->animIndex = obj->animIndex;
+		if (!part) continue;
+		state->speed = part->speed;
+		state->contacts[CONTACT_TOP] = part->top;
+		state->contacts[CONTACT_RIGHT] = part->right;
+		state->contacts[CONTACT_BOTTOM] = part->bottom;
+		state->contacts[CONTACT_LEFT] = part->left;
+		state->sleeping = part->sleeping;
+	}
+}
+
+bool restoreWorld(World *world, WorldSnapshot *snapshot)
+{
+	int n = snapshot->bodies, i;
+	Body *bodies = (Body *)snapshot->data;
+	ObjectState *states = (ObjectState *)(bodies + n);
+	if (n != world->size) return false;
+	for (i = 0; i < n; i++)
+		if (bodies[i].obj != world->bodies[i].obj || bodies[i].part != world->bodies[i].part) return false;
+
+	memcpy(world->bodies, bodies, n * sizeof(Body));
+	memcpy(world->order, states + n, n * sizeof(int));
+	for (i = 0; i < n; i++)
+	{
+		Object *obj = bodies[i].obj;
+		Particle *part = bodies[i].part;
+		ObjectState *state = &states[i];
+		obj->bounds = state->bounds;
+		obj->imgIndex = state->imgIndex;
+		obj->imgTimer = state->imgTimer;
+		obj->animIndex = state->animIndex;
+		if (!part) continue;
+		part->speed = state->speed;
+		part->top = state->contacts[CONTACT_TOP];
+		part->right = state->contacts[CONTACT_RIGHT];
+		part->bottom = state->contacts[CONTACT_BOTTOM];
+		part->left = state->contacts[CONTACT_LEFT];
+		part->sleeping = state->sleeping;
+	}
+	world->numEvents = 0;
+	world->gridDirty = true;
+	world->previousValid = false;
+	return true;
+}
+
+void freeWorldSnapshot(WorldSnapshot *snapshot)
+{
+	taggedFree(snapshot->data);
+	taggedFree(snapshot);
+}
+
+void freeWorld(World *world)
+{
+	int i;
+	for (i = 0; i < getThreadCount(world->threads); i++)
+		taggedFree(world->pairs[i]);
+	if (world->threads) freeThreadPool(world->threads);
+	taggedFree(world->pairs);
+	taggedFree(world->numPairs);
+	taggedFree(world->bodies);
+	taggedFree(world->order);
+	taggedFree(world->awake);
+	taggedFree(world->parents);
+	taggedFree(world->candidateStart);
+	taggedFree(world->candidates);
+	taggedFree(world->previousStart);
+	taggedFree(world->previousCandidates);
+	taggedFree(world->scratch);
+	taggedFree(world->events);
+	taggedFree(world->cellStart);
+	taggedFree(world->cellBodies);
+	taggedFree(world);
+}
+
+void addBody(World *world, Object *obj, Particle *part)
+{
+	if (world->size == world->capacity)
+	{
+		int capacity = world->capacity ? world->capacity * 2 : 64;
+		world->bodies = (Body *)growArray(world->bodies, world->size, capacity, sizeof(Body));
+		world->order = (int *)growArray(world->order, world->size, capacity, sizeof(int));
+		world->awake = (int *)growArray(world->awake, 0, capacity, sizeof(int));
+		world->parents = (int *)growArray(world->parents, world->size, capacity, sizeof(int));
+		world->candidateStart = (int *)growArray(world->candidateStart, world->size + 1, capacity + 1, sizeof(int));
+		world->previousStart = (int *)growArray(world->previousStart, world->size + 1, capacity + 1, sizeof(int));
+		world->capacity = capacity;
+		resizeThreadBuffers(world);
+	}
+	Body *b = &world->bodies[world->size];
+	b->obj = obj;
+	b->part = part;
+	b->area = b->bounds = getBounds(obj);
+	b->added = true;
+	b->cached = false;
+	b->contacts[CONTACT_TOP] = b->contacts[CONTACT_RIGHT] = b->contacts[CONTACT_BOTTOM] = b->contacts[CONTACT_LEFT] = NULL;
+	b->contactBodies[CONTACT_TOP] = b->contactBodies[CONTACT_RIGHT] = b->contactBodies[CONTACT_BOTTOM] = b->contactBodies[CONTACT_LEFT] = -1;
+	b->candidatesChanged = true;
+	b->idleFrames = 0;
+	b->island = world->size;
+	b->asleep = b->listed = false;
+	if (part) part->sleeping = false;
+	world->order[world->size] = world->size;
+	world->parents[world->size] = world->size;
+	world->size++;
+	world->gridDirty = true;
+}
+
+void *growArray(void *array, int count, int newCount, size_t itemSize)
+{
+	void *grown = taggedMalloc(newCount * itemSize, MEMORY_PHYSICS);
+	if (array)
+	{
+		memcpy(grown, array, count * itemSize);
+		taggedFree(array);
+	}
+	return grown;
+}
+
+void resizeThreadBuffers(World *world)
+{
+	// Os vetores por thread são sempre alocados pela thread principal, para que as demais nunca aloquem memória
+	int threads = getThreadCount(world->threads), i;
+	if (world->pairs)
+	{
+		for (i = 0; world->pairs[i]; i++)
+			taggedFree(world->pairs[i]);
+		taggedFree(world->pairs);
+		taggedFree(world->numPairs);
+	}
+	world->pairs = (int **)taggedMalloc((threads + 1) * sizeof(int *), MEMORY_PHYSICS);
+	world->numPairs = (int *)taggedMalloc(threads * sizeof(int), MEMORY_PHYSICS);
+	for (i = 0; i < threads; i++)
+	{
+		world->pairs[i] = (int *)taggedMalloc(2 * world->pairsCapacity * sizeof(int), MEMORY_PHYSICS);
+		world->numPairs[i] = 0;
+	}
+	world->pairs[threads] = NULL;
+
+	taggedFree(world->scratch);
+	world->scratch = (Object **)taggedMalloc((threads * world->capacity + 1) * sizeof(Object *), MEMORY_PHYSICS);
+}
+
+void updateAreas(int first, int last, int thread, void *data)
+{
+	World *world = (World *)data;
+	int i;
+	for (i = first; i < last; i++)
+	{
+		Body *b = &world->bodies[i];
+		if (b->asleep) continue;
+		Rectangle bounds = getBounds(b->obj);
+		b->moved = b->added || memcmp(&bounds, &b->bounds, sizeof(Rectangle)) != 0;
+		b->added = false;
+		b->bounds = bounds;
+		b->area = b->part ? getSweptArea(b->part) : bounds;
+	}
+}
+
+void sortBodies(World *world)
+{
+	// Ordenação por inserção: como os corpos se movem pouco entre frames, a ordem anterior está quase correta e o custo é quase linear
+	int i, j;
+	for (i = 1; i < world->size; i++)
+	{
+		int body = world->order[i];
+		float left = world->bodies[body].area.position.x;
+		for (j = i - 1; j >= 0 && world->bodies[world->order[j]].area.position.x > left; j--)
+			world->order[j + 1] = world->order[j];
+		world->order[j + 1] = body;
+	}
+}
+
+void findPairs(int first, int last, int thread, void *data)
+{
+	World *world = (World *)data;
+	int *pairs = world->pairs[thread], count = 0, i, j;
+	for (i = first; i < last; i++)
+	{
+		Body *a = &world->bodies[world->order[i]];
+		float right = a->area.position.x + a->area.size.x;
+		for (j = i + 1; j < world->size; j++)
+		{
+			Body *b = &world->bodies[world->order[j]];
+			if (b->area.position.x >= right) break;
+
+			// Apenas pares com pelo menos uma partícula acordada que colide com a categoria do outro corpo interessam
+			if (!collidesWith(a, b) && !collidesWith(b, a)) continue;
+			if (!intersects(a->area, b->area)) continue;
+
+			// Pares além da capacidade são apenas contados, e a busca será refeita com vetores maiores
+			if (count < world->pairsCapacity)
+			{
+				pairs[2 * count] = world->order[i];
+				pairs[2 * count + 1] = world->order[j];
+			}
+			count++;
+		}
+	}
+	world->numPairs[thread] = count;
+}
+
+void findCandidates(World *world)
+{
+	// As listas do passo anterior são mantidas para que sortCandidates detecte as que mudaram
+	int *swap = world->previousStart;
+	world->previousStart = world->candidateStart;
+	world->candidateStart = swap;
+	swap = world->previousCandidates;
+	world->previousCandidates = world->candidates;
+	world->candidates = swap;
+	int capacity = world->previousCapacity;
+	world->previousCapacity = world->candidatesCapacity;
+	world->candidatesCapacity = capacity;
+
+	int *start = world->candidateStart, threads = getThreadCount(world->threads), t, i;
+	Body *bodies = world->bodies;
+	memset(start, 0, (world->size + 1) * sizeof(int));
+	for (t = 0; t < threads; t++)
+		for (i = 0; i < world->numPairs[t]; i++)
+		{
+			int a = world->pairs[t][2 * i], b = world->pairs[t][2 * i + 1];
+			if (collidesWith(&bodies[a], &bodies[b])) start[a + 1]++;
+			if (collidesWith(&bodies[b], &bodies[a])) start[b + 1]++;
+		}
+	for (i = 0; i < world->size; i++)
+		start[i + 1] += start[i];
+
+	if (start[world->size] > world->candidatesCapacity)
+	{
+		taggedFree(world->candidates);
+		world->candidatesCapacity = 2 * start[world->size];
+		world->candidates = (int *)taggedMalloc(world->candidatesCapacity * sizeof(int), MEMORY_PHYSICS);
+	}
+
+	// Preenche usando start[i] como cursor; ao final, start[i] aponta para o início da lista seguinte e é restaurado
+	for (t = 0; t < threads; t++)
+		for (i = 0; i < world->numPairs[t]; i++)
+		{
+			int a = world->pairs[t][2 * i], b = world->pairs[t][2 * i + 1];
+			if (collidesWith(&bodies[a], &bodies[b])) world->candidates[start[a]++] = b;
+			if (collidesWith(&bodies[b], &bodies[a])) world->candidates[start[b]++] = a;
+		}
+	for (i = world->size; i > 0; i--)
+		start[i] = start[i - 1];
+	start[0] = 0;
+
+	runParallel(world->threads, sortCandidates, world->numAwake, world);
+	world->previousValid = true;
+}
+
+void sortCandidates(int first, int last, int thread, void *data)
+{
+	// Os candidatos de cada partícula são tratados na ordem de inserção, como numa lista de obstáculos
+	World *world = (World *)data;
+	int i, j, k;
+	for (i = first; i < last; i++)
+	{
+		int body = world->awake[i];
+		Body *b = &world->bodies[body];
+		int *c = &world->candidates[world->candidateStart[body]], n = world->candidateStart[body + 1] - world->candidateStart[body];
+		for (j = 1; j < n; j++)
+		{
+			int v = c[j];
+			for (k = j - 1; k >= 0 && c[k] > v; k--)
+				c[k + 1] = c[k];
+			c[k + 1] = v;
+		}
+
+		// Com a lista ordenada, basta compará-la com a do passo anterior. Um corpo recém-adicionado sempre se moveu, e não tem lista anterior
+		b->candidatesChanged = b->moved || !world->previousValid ||
+			world->previousStart[body + 1] - world->previousStart[body] != n ||
+			(n > 0 && memcmp(c, &world->previousCandidates[world->previousStart[body]], n * sizeof(int)) != 0);
+		for (j = 0; j < n && !b->candidatesChanged; j++)
+			if (world->bodies[c[j]].moved) b->candidatesChanged = true;
+	}
+}
+
+void findContacts(int first, int last, int thread, void *data)
+{
+	World *world = (World *)data;
+	Object **scratch = world->scratch + thread * world->capacity;
+	int i;
+	for (i = first; i < last; i++)
+	{
+		int body = world->awake[i];
+		Body *b = &world->bodies[body];
+		if (world->rescan || !b->cached || b->moved || !reuseContacts(world, body, scratch))
+			findParticleContacts(b->part, scratch, gatherCandidates(world, body, scratch), world->tiles);
+		b->cached = true;
+	}
+}
+
+int gatherCandidates(World *world, int body, Object **scratch)
+{
+	int count = 0, j;
+	for (j = world->candidateStart[body]; j < world->candidateStart[body + 1]; j++)
+		scratch[count++] = world->bodies[world->candidates[j]].obj;
+	return count;
+}
+
+bool reuseContacts(World *world, int body, Object **scratch)
+{
+	Body *b = &world->bodies[body];
+	Particle *part = b->part;
+	Object **sides[4] = {&part->top, &part->right, &part->bottom, &part->left};
+	int first = world->candidateStart[body], last = world->candidateStart[body + 1], position[4], s, j;
+
+	// Caso comum em repouso: os contatos não se moveram e nenhum candidato novo ou em movimento pode ter criado outro contato
+	for (s = 0; s < 4; s++)
+		if (b->contactBodies[s] >= 0 && world->bodies[b->contactBodies[s]].moved) return false;
+	if (!b->candidatesChanged) return true;
+
+	// Posição de cada contato guardado entre os candidatos: -1 para a grade (tratada antes dos candidatos) ou lado vazio, -2 se ainda não foi encontrado
+	for (s = 0; s < 4; s++)
+		position[s] = *sides[s] == NULL || (world->tiles && *sides[s] == world->tiles->tile) ? -1 : -2;
+	for (j = first; j < last; j++)
+	{
+		Body *c = &world->bodies[world->candidates[j]];
+		for (s = 0; s < 4; s++)
+			if (*sides[s] == c->obj)
+			{
+				if (c->moved) return false;
+				position[s] = j;
+			}
+	}
+
+	// Um contato que saiu do alcance ou foi removido do mundo pode esconder outro obstáculo do mesmo lado, então tudo é recalculado
+	for (s = 0; s < 4; s++)
+		if (position[s] == -2) return false;
+
+	// Apenas os candidatos que se moveram podem ter criado contatos novos. Como na busca completa, o último candidato encostado em cada lado prevalece
+	for (j = first; j < last; j++)
+	{
+		Body *c = &world->bodies[world->candidates[j]];
+		if (!c->moved) continue;
+		Object *previous[4];
+		for (s = 0; s < 4; s++)
+			previous[s] = *sides[s];
+		scratch[0] = c->obj;
+		addParticleContacts(part, scratch, 1);
+		for (s = 0; s < 4; s++)
+			if (*sides[s] != previous[s])
+			{
+				if (position[s] > j) *sides[s] = previous[s];
+				else position[s] = j;
+			}
+	}
+	return true;
+}
+
+void addContactEvents(World *world, int body)
+{
+	Body *b = &world->bodies[body];
+	Object *sides[4] = {b->part->top, b->part->right, b->part->bottom, b->part->left};
+	int s;
+	for (s = 0; s < 4; s++)
+	{
+		if (sides[s] == b->contacts[s]) continue;
+		if (world->numEvents + 2 > world->eventsCapacity)
+		{
+			int capacity = world->eventsCapacity ? world->eventsCapacity * 2 : 64;
+			world->events = (ContactEvent *)growArray(world->events, world->numEvents, capacity, sizeof(ContactEvent));
+			world->eventsCapacity = capacity;
+		}
+		ContactEvent *e = &world->events[world->numEvents];
+		if (b->contacts[s])
+		{
+			e->part = b->part, e->obs = b->contacts[s], e->side = (ContactSide)s, e->begin = false;
+			e++, world->numEvents++;
+		}
+		if (sides[s])
+		{
+			e->part = b->part, e->obs = sides[s], e->side = (ContactSide)s, e->begin = true;
+			world->numEvents++;
+		}
+		b->contacts[s] = sides[s];
+		b->contactBodies[s] = findContactBody(world, body, sides[s]);
+	}
+}
+
+int findContactBody(World *world, int body, Object *obj)
+{
+	// Só é chamada quando um contato muda. Os contatos vêm sempre dos candidatos ou da grade de colisão
+	int j;
+	if (!obj) return -1;
+	for (j = world->candidateStart[body]; j < world->candidateStart[body + 1]; j++)
+		if (world->bodies[world->candidates[j]].obj == obj) return world->candidates[j];
+	return -1;
+}
+
+void wakeIsland(World *world, int body)
+{
+	int i = body;
+	do
+	{
+		Body *b = &world->bodies[i];
+		int next = b->island;
+		b->asleep = b->part->sleeping = false;
+		b->cached = false;
+		b->idleFrames = 0;
+		b->island = i;
+		i = next;
+	} while (i != body);
+}
+
+void listBody(World *world, int body, int *count)
+{
+	if (world->bodies[body].listed) return;
+	world->bodies[body].listed = true;
+	world->awake[(*count)++] = body;
+}
+
+int findIsland(World *world, int body)
+{
+	int *parents = world->parents;
+	while (parents[body] != body)
+	{
+		parents[body] = parents[parents[body]];
+		body = parents[body];
+	}
+	return body;
+}
+
+void updateIslands(World *world)
+{
+	Body *bodies = world->bodies;
+	int threads = getThreadCount(world->threads), count = 0, t, i;
+	float minSqr = world->sleepSpeed * world->sleepSpeed;
+
+	for (i = 0; i < world->numAwake; i++)
+	{
+		Body *b = &bodies[world->awake[i]];
+		Point speed = b->part->speed;
+		b->idleFrames = speed.x * speed.x + speed.y * speed.y < minSqr ? b->idleFrames + 1 : 0;
+		listBody(world, world->awake[i], &count);
+	}
+
+	// Partículas que se tocam ao final do movimento pertencem à mesma ilha. Uma partícula dormindo tocada por uma acordada acorda junto com sua ilha
+	for (t = 0; t < threads; t++)
+		for (i = 0; i < world->numPairs[t]; i++)
+		{
+			int a = world->pairs[t][2 * i], b = world->pairs[t][2 * i + 1];
+			if (bodies[a].part == NULL || bodies[b].part == NULL) continue;
+			if (!touches(getBounds(bodies[a].obj), getBounds(bodies[b].obj))) continue;
+			if (bodies[a].asleep) wakeIsland(world, a);
+			if (bodies[b].asleep) wakeIsland(world, b);
+			listBody(world, a, &count);
+			listBody(world, b, &count);
+			world->parents[findIsland(world, a)] = findIsland(world, b);
+		}
+
+	// Uma ilha adormece quando todas as suas partículas estão paradas há sleepFrames frames. O campo 'island' do representante vale -1 se alguma não está, ou é o início do ciclo da ilha
+	for (i = 0; i < count; i++)
+		if (findIsland(world, world->awake[i]) == world->awake[i])
+			bodies[world->awake[i]].island = world->awake[i];
+	for (i = 0; i < count; i++)
+		if (bodies[world->awake[i]].idleFrames < world->sleepFrames)
+			bodies[findIsland(world, world->awake[i])].island = -1;
+	for (i = 0; i < count; i++)
+	{
+		int body = world->awake[i], root = findIsland(world, body);
+		Body *b = &bodies[body];
+		if (bodies[root].island >= 0)
+		{
+			if (body != root)
+			{
+				b->island = bodies[root].island;
+				bodies[root].island = body;
+			}
+			b->asleep = b->part->sleeping = true;
+			b->part->speed = newPoint(0, 0);
+			b->area = getSweptArea(b->part);
+		}
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		world->parents[world->awake[i]] = world->awake[i];
+		bodies[world->awake[i]].listed = false;
+	}
+}
+
+bool touches(Rectangle a, Rectangle b)
+{
+	return
+		a.position.x + a.size.x >= b.position.x && b.position.x + b.size.x >= a.position.x &&
+		a.position.y + a.size.y >= b.position.y && b.position.y + b.size.y >= a.position.y;
+}
+
+void checkQueryGrid(World *world)
+{
+	// A grade só precisa ser remontada se algum corpo saiu de onde estava quando ela foi montada; comparar os limites custa bem menos que remontá-la
+	if (world->gridDirty) return;
+	int i;
+	for (i = 0; i < world->size; i++)
+	{
+		Rectangle bounds = getBounds(world->bodies[i].obj);
+		if (memcmp(&bounds, &world->bodies[i].queryBounds, sizeof(Rectangle)) != 0)
+		{
+			world->gridDirty = true;
+			return;
+		}
+	}
+}
+void buildQueryGrid(World *world)
+{
+	// O lado das células é o dobro do tamanho médio dos corpos, aumentado se a grade ficar grande demais para o número de corpos
+	int i, col, line;
+	float left = INFINITY, top = INFINITY, right = -INFINITY, bottom = -INFINITY, sizes = 0;
+	for (i = 0; i < world->size; i++)
+	{
+		Rectangle r = world->bodies[i].queryBounds = getBounds(world->bodies[i].obj);
+		if (r.position.x < left) left = r.position.x;
+		if (r.position.y < top) top = r.position.y;
+		if (r.position.x + r.size.x > right) right = r.position.x + r.size.x;
+		if (r.position.y + r.size.y > bottom) bottom = r.position.y + r.size.y;
+		sizes += r.size.x + r.size.y;
+	}
+	if (world->size == 0) left = top = right = bottom = 0;
+	world->gridOrigin = newPoint(left, top);
+	world->cellSize = world->size > 0 && sizes > 0 ? sizes / world->size : 1;
+	do
+	{
+		world->gridColumns = (int)((right - left) / world->cellSize) + 1;
+		world->gridLines = (int)((bottom - top) / world->cellSize) + 1;
+		if ((float)world->gridColumns * world->gridLines <= 4 * world->size + 16) break;
+		world->cellSize *= 2;
+	} while (true);
+
+	int cells = world->gridColumns * world->gridLines;
+	if (cells + 1 > world->cellsCapacity)
+	{
+		taggedFree(world->cellStart);
+		world->cellsCapacity = 2 * (cells + 1);
+		world->cellStart = (int *)taggedMalloc(world->cellsCapacity * sizeof(int), MEMORY_PHYSICS);
+	}
+
+	// Ordenação por contagem: conta os corpos de cada célula, acumula os inícios e então distribui os índices
+	memset(world->cellStart, 0, (cells + 1) * sizeof(int));
+	for (i = 0; i < world->size; i++)
+	{
+		int col0, line0, col1, line1;
+		getCellRange(world, world->bodies[i].queryBounds, &col0, &line0, &col1, &line1);
+		for (line = line0; line <= line1; line++)
+			for (col = col0; col <= col1; col++)
+				world->cellStart[col + line * world->gridColumns + 1]++;
+	}
+	for (i = 0; i < cells; i++)
+		world->cellStart[i + 1] += world->cellStart[i];
+	int total = world->cellStart[cells];
+	if (total > world->cellBodiesCapacity)
+	{
+		taggedFree(world->cellBodies);
+		world->cellBodiesCapacity = 2 * total;
+		world->cellBodies = (int *)taggedMalloc(world->cellBodiesCapacity * sizeof(int), MEMORY_PHYSICS);
+	}
+	for (i = 0; i < world->size; i++)
+	{
+		int col0, line0, col1, line1;
+		getCellRange(world, world->bodies[i].queryBounds, &col0, &line0, &col1, &line1);
+		for (line = line0; line <= line1; line++)
+			for (col = col0; col <= col1; col++)
+				world->cellBodies[world->cellStart[col + line * world->gridColumns]++] = i;
+	}
+
+	// A distribuição avançou cada início até o início da célula seguinte
+	for (i = cells; i > 0; i--)
+		world->cellStart[i] = world->cellStart[i - 1];
+	world->cellStart[0] = 0;
+	world->gridDirty = false;
+}
+
+void getCellRange(World *world, Rectangle area, int *col0, int *line0, int *col1, int *line1)
+{
+	// As células fora da grade são trocadas pelas da borda, que contêm todos os corpos daquele lado
+	float x0 = (area.position.x - world->gridOrigin.x) / world->cellSize, y0 = (area.position.y - world->gridOrigin.y) / world->cellSize,
+		x1 = x0 + area.size.x / world->cellSize, y1 = y0 + area.size.y / world->cellSize,
+		maxX = world->gridColumns - 1, maxY = world->gridLines - 1;
+	*col0 = x0 < 0 ? 0 : x0 > maxX ? maxX : (int)x0;
+	*line0 = y0 < 0 ? 0 : y0 > maxY ? maxY : (int)y0;
+	*col1 = x1 < 0 ? 0 : x1 > maxX ? maxX : (int)x1;
+	*line1 = y1 < 0 ? 0 : y1 > maxY ? maxY : (int)y1;
+}
+
+bool clipSegment(Rectangle rect, Point from, Point delta, float *enter, float *exit)
+{
+	// Método das faixas (slabs): intersecção dos intervalos de tempo em que o segmento está entre as bordas de cada eixo
+	float t0 = 0, t1 = 1;
+	float origin[2] = {from.x, from.y}, dir[2] = {delta.x, delta.y},
+		low[2] = {rect.position.x, rect.position.y}, high[2] = {rect.position.x + rect.size.x, rect.position.y + rect.size.y};
+	int axis;
+	for (axis = 0; axis < 2; axis++)
+	{
+		if (dir[axis] == 0)
+		{
+			if (origin[axis] < low[axis] || origin[axis] >= high[axis]) return false;
+			continue;
+		}
+		float a = (low[axis] - origin[axis]) / dir[axis], b = (high[axis] - origin[axis]) / dir[axis];
+		if (a > b)
+		{
+			float swap = a;
+			a = b;
+			b = swap;
+		}
+		if (a > t0) t0 = a;
+		if (b < t1) t1 = b;
+		if (t0 > t1) return false;
+	}
+	*enter = t0;
+	*exit = t1;
+	return true;
+}
+
+float castRayTiles(TileMap *map, Point from, Point delta)
+{
+	Rectangle bounds = newRectangle(map->origin.x, map->origin.y, map->columns * map->tileSize.x, map->lines * map->tileSize.y);
+	float enter, exit;
+	if (!clipSegment(bounds, from, delta, &enter, &exit)) return INFINITY;
+
+	// O ponto de entrada pode cair um pouco fora da grade por arredondamento, em qualquer das bordas. Limitá-lo ainda em float evita
+	// a conversão para int de coordenadas enormes
+	Point start = newPoint(from.x + delta.x * enter, from.y + delta.y * enter);
+	start.x = fminf(fmaxf(start.x, bounds.position.x), bounds.position.x + bounds.size.x);
+	start.y = fminf(fmaxf(start.y, bounds.position.y), bounds.position.y + bounds.size.y);
+	int col = (int)floorf((start.x - map->origin.x) / map->tileSize.x), line = (int)floorf((start.y - map->origin.y) / map->tileSize.y);
+	if (col >= map->columns) col = map->columns - 1;
+	if (line >= map->lines) line = map->lines - 1;
+	if (col < 0) col = 0;
+	if (line < 0) line = 0;
+	int stepX = delta.x > 0 ? 1 : -1, stepY = delta.y > 0 ? 1 : -1;
+	float nextX = delta.x == 0 ? INFINITY : (map->origin.x + (col + (stepX > 0)) * map->tileSize.x - from.x) / delta.x,
+		nextY = delta.y == 0 ? INFINITY : (map->origin.y + (line + (stepY > 0)) * map->tileSize.y - from.y) / delta.y,
+		stepTX = delta.x == 0 ? INFINITY : map->tileSize.x / fabsf(delta.x),
+		stepTY = delta.y == 0 ? INFINITY : map->tileSize.y / fabsf(delta.y);
+
+	// A célula onde o segmento começa é ignorada se contiver o ponto de partida
+	float t = enter;
+	while (t <= 1)
+	{
+		if (isTileSolid(map, col, line) && t > 0) return t;
+		if (nextX < nextY)
+		{
+			t = nextX;
+			col += stepX;
+			nextX += stepTX;
+		}
+		else
+		{
+			t = nextY;
+			line += stepY;
+			nextY += stepTY;
+		}
+		if (col < 0 || col >= map->columns || line < 0 || line >= map->lines) break;
+	}
+	return INFINITY;
+}
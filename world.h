@@ -0,0 +1,318 @@
+/** @file */
+
+#ifndef MINI_WORLD_H
+#define MINI_WORLD_H
+
+#include "particle.h"
+#include "threadpool.h"
+
+/// Lado de uma partícula onde ocorre um contato
+typedef enum {
+	/// Acima da partícula (campo top)
+	CONTACT_TOP,
+
+	/// À direita da partícula (campo right)
+	CONTACT_RIGHT,
+
+	/// Abaixo da partícula (campo bottom)
+	CONTACT_BOTTOM,
+
+	/// À esquerda da partícula (campo left)
+	CONTACT_LEFT
+} ContactSide;
+
+/// Início ou fim de um contato entre uma partícula e um obstáculo, gerado por stepPhysics
+typedef struct {
+	/// Partícula do contato
+	Particle *part;
+
+	/// Obstáculo do contato. Num evento de fim, o obstáculo pode já ter sido removido do mundo
+	Object *obs;
+
+	/// Lado da partícula onde está o contato
+	ContactSide side;
+
+	/// Verdadeiro se o contato começou neste passo, falso se terminou
+	bool begin;
+} ContactEvent;
+
+/// Corpo de um mundo físico: uma partícula, que se move, ou um obstáculo fixo
+typedef struct {
+	/// Objeto do corpo. Para partículas, é o objeto da partícula
+	Object *obj;
+
+	/// Partícula do corpo, ou nula se o corpo for um obstáculo fixo
+	Particle *part;
+
+	/// Área usada para encontrar os pares de corpos próximos: a área varrida no próximo movimento para partículas, e os limites para obstáculos
+	Rectangle area;
+
+	/// Limites do objeto no início do passo atual
+	Rectangle bounds;
+
+	/// Verdadeiro se os limites mudaram desde o início do passo anterior, ou se o corpo acabou de ser adicionado
+	bool moved;
+
+	/// Verdadeiro até o primeiro passo após o corpo ser adicionado
+	bool added;
+
+	/// Verdadeiro se os contatos da partícula foram calculados no passo anterior e podem ser reaproveitados se nada se mover
+	bool cached;
+
+	/// Contatos da partícula ao final do passo anterior (top, right, bottom e left), usados para gerar os eventos de contato
+	Object *contacts[4];
+
+	/// Índices em 'bodies' dos corpos de 'contacts', ou -1 para os lados vazios e para a grade de colisão
+	int contactBodies[4];
+
+	/// Verdadeiro se algum candidato da partícula se moveu ou se sua lista de candidatos mudou desde o passo anterior
+	bool candidatesChanged;
+
+	/// Total de frames consecutivos em que a partícula ficou abaixo da velocidade de repouso
+	int idleFrames;
+
+	/// Próximo corpo da ilha com a qual a partícula está dormindo. As ilhas formam ciclos, e acordar um corpo acorda o ciclo inteiro
+	int island;
+
+	/// Verdadeiro se a partícula está dormindo
+	bool asleep;
+
+	/// Verdadeiro enquanto o corpo participa da montagem das ilhas do frame atual
+	bool listed;
+
+	/// Limites do objeto quando a grade das consultas espaciais foi montada
+	Rectangle queryBounds;
+} Body;
+
+/// Mundo físico, que reúne partículas e obstáculos para movimentá-los todos de uma vez com stepPhysics. Os pares de corpos próximos são encontrados por ordenação e varredura no eixo x (sort and sweep), aproveitando que a ordem muda pouco de um frame para o outro. A busca de pares e de contatos pode ser dividida entre várias threads (ver setPhysicsThreads).
+///
+/// Os contatos de cada partícula são guardados entre passos: se nem a partícula nem seus contatos se moveram, apenas os corpos próximos que se moveram são testados, e nenhum é testado se a lista de corpos próximos é a mesma do passo anterior e nenhum deles se moveu. As mudanças de contato geram eventos em 'events', para que o jogo não precise comparar top, right, bottom e left a cada frame.
+///
+/// Partículas que ficam paradas por alguns frames adormecem junto com as partículas em contato com elas (uma ilha) e deixam de ser processadas, servindo apenas de obstáculo, até que setSpeed, setForces, wakeParticle ou o toque de uma partícula acordada as acorde
+typedef struct {
+	/// Corpos do mundo, na ordem em que foram adicionados
+	Body *bodies;
+
+	/// Total de corpos
+	int size;
+
+	/// Total de corpos que cabem em 'bodies' sem realocação
+	int capacity;
+
+	/// Índices dos corpos, ordenados pela borda esquerda de suas áreas
+	int *order;
+
+	/// Pares de corpos cujas áreas se interceptam no frame atual, encontrados por cada thread (dois índices por par)
+	int **pairs;
+
+	/// Total de pares encontrados por cada thread
+	int *numPairs;
+
+	/// Total de pares que cabem no vetor de cada thread sem realocação
+	int pairsCapacity;
+
+	/// Para cada corpo i, os obstáculos candidatos estão em candidates[candidateStart[i]] até candidates[candidateStart[i + 1] - 1]
+	int *candidateStart;
+
+	/// Índices dos corpos candidatos de cada partícula, em ordem crescente
+	int *candidates;
+
+	/// Total de índices que cabem em 'candidates' sem realocação
+	int candidatesCapacity;
+
+	/// Listas de candidatos do passo anterior, no mesmo formato de 'candidateStart' e 'candidates', usadas para detectar mudanças nas listas
+	int *previousStart;
+	int *previousCandidates;
+
+	/// Total de índices que cabem em 'previousCandidates' sem realocação
+	int previousCapacity;
+
+	/// Verdadeiro se as listas do passo anterior usam os mesmos índices de corpos que as atuais. Remover corpos ou restaurar um instantâneo as invalida
+	bool previousValid;
+
+	/// Índices das partículas acordadas no frame atual, em ordem de inserção, seguidos dos corpos acordados pelo toque delas
+	int *awake;
+
+	/// Total de partículas acordadas no início do frame atual
+	int numAwake;
+
+	/// Representante de cada corpo na montagem das ilhas (union-find). Fora de stepPhysics, cada corpo representa a si mesmo
+	int *parents;
+
+	/// Velocidade abaixo da qual uma partícula é considerada parada
+	float sleepSpeed;
+
+	/// Total de frames parada após os quais uma ilha adormece. Zero desativa o adormecimento
+	int sleepFrames;
+
+	/// Verdadeiro se as partículas são movimentadas com detecção contínua de colisão (como em moveParticleSwept)
+	bool continuous;
+
+	/// Eventos de início e fim de contato do último passo, na ordem de inserção das partículas. Válidos até a próxima chamada de stepPhysics
+	ContactEvent *events;
+
+	/// Total de eventos do último passo
+	int numEvents;
+
+	/// Total de eventos que cabem em 'events' sem realocação
+	int eventsCapacity;
+
+	/// Grade de colisão e seu contador de alterações quando os contatos guardados foram calculados. Se algum mudar, todos os contatos são recalculados
+	TileMap *contactTiles;
+	int contactTilesVersion;
+
+	/// Verdadeiro se nenhum contato guardado pode ser reaproveitado no passo atual
+	bool rescan;
+
+	/// Objetos candidatos da partícula sendo tratada por cada thread ('capacity' posições por thread)
+	Object **scratch;
+
+	/// Threads usadas por stepPhysics. Nulo quando é usada apenas a thread atual
+	ThreadPool *threads;
+
+	/// Grade de colisão com a geometria fixa da fase. Pode ser nula
+	TileMap *tiles;
+
+	/// Grade uniforme usada pelas consultas espaciais: posição do canto superior esquerdo, lado das células e total de colunas e linhas. Cobre os limites de todos os corpos
+	Point gridOrigin;
+	float cellSize;
+	int gridColumns, gridLines;
+
+	/// Para cada célula c, os índices dos corpos que a interceptam estão em cellBodies[cellStart[c]] até cellBodies[cellStart[c + 1] - 1]
+	int *cellStart;
+	int *cellBodies;
+
+	/// Total de posições que cabem em 'cellStart' e 'cellBodies' sem realocação
+	int cellsCapacity, cellBodiesCapacity;
+
+	/// Verdadeiro se a grade das consultas precisa ser remontada. Adicionar ou remover corpos, ou um stepPhysics em que algum corpo saiu de onde estava, invalidam a grade, que é remontada na consulta seguinte
+	bool gridDirty;
+} World;
+
+/// Instantâneo do estado da simulação de um mundo físico, guardado num único bloco contíguo: os corpos, com seus contatos e estado de repouso, e as posições, velocidades, contatos e contadores de animação de seus objetos e partículas. Permite voltar o mundo a um frame anterior (por exemplo, para rollback em jogos em rede ou para reiniciar uma fase) sem recriar objetos nem recarregar imagens
+typedef struct {
+	/// Bloco com o estado gravado
+	void *data;
+
+	/// Total de bytes usados em 'data'
+	int size;
+
+	/// Total de bytes que cabem em 'data' sem realocação
+	int capacity;
+
+	/// Total de corpos do mundo quando o instantâneo foi gravado
+	int bodies;
+} WorldSnapshot;
+
+/// Cria um mundo físico vazio
+///
+/// @return O mundo gerado
+World *newWorld();
+
+/// Adiciona uma partícula a um mundo. Ela será movimentada por stepPhysics e servirá de obstáculo para as demais
+///
+/// @param world Mundo onde a partícula será adicionada
+/// @param part Partícula a adicionar
+void addParticleToWorld(World *world, Particle *part);
+
+/// Adiciona um obstáculo fixo a um mundo
+///
+/// @param world Mundo onde o obstáculo será adicionado
+/// @param obj Obstáculo a adicionar
+void addObstacleToWorld(World *world, Object *obj);
+
+/// Remove uma partícula ou obstáculo de um mundo. A partícula ou obstáculo não é deletado. As partículas dormindo que o tocavam são acordadas
+///
+/// @param world Mundo de onde o corpo será removido
+/// @param obj Objeto do corpo a ser removido (para partículas, o objeto da partícula)
+void removeFromWorld(World *world, Object *obj);
+
+/// Define a grade de colisão com a geometria fixa de um mundo
+///
+/// @param world Mundo a ser alterado
+/// @param tiles Grade de colisão. Pode ser nula
+void setWorldTiles(World *world, TileMap *tiles);
+
+/// Define quando as partículas de um mundo adormecem. Uma ilha de partículas em contato adormece quando todas ficaram abaixo da velocidade de repouso por 'frames' frames seguidos. O padrão é velocidade 0.01 por 30 frames
+///
+/// @param world Mundo a ser alterado
+/// @param speed Velocidade abaixo da qual uma partícula é considerada parada
+/// @param frames Total de frames parada até adormecer. Zero desativa o adormecimento e acorda todas as partículas
+void setWorldSleep(World *world, float speed, int frames);
+
+/// Define se stepPhysics usa detecção contínua de colisão, que encontra o primeiro impacto de cada partícula entre todos os candidatos e a faz deslizar pelo tempo restante (ver moveParticleSwept). O padrão é falso
+///
+/// @param world Mundo a ser alterado
+/// @param continuous Verdadeiro para usar detecção contínua, falso para o tratamento de moveParticleArray
+void setWorldContinuous(World *world, bool continuous);
+
+/// Define quantas threads são usadas por stepPhysics. O resultado de stepPhysics é exatamente o mesmo para qualquer quantidade de threads
+///
+/// @param world Mundo a ser alterado
+/// @param threads Total de threads, contando a thread que chama stepPhysics. O padrão é 1
+void setPhysicsThreads(World *world, int threads);
+
+/// Movimenta todas as partículas de um mundo com o mesmo tratamento de colisão de moveParticleArray (ou de moveParticleSwept, ver setWorldContinuous). Cada partícula considera apenas os corpos cujas áreas interceptam a sua, na ordem em que foram adicionados, e a grade de colisão. Primeiro os contatos de todas as partículas acordadas são encontrados, em paralelo, com as posições do início do passo; depois as partículas são movimentadas uma a uma, na ordem em que foram adicionadas. Partículas dormindo não são movimentadas, e um mundo em que todas dormem custa apenas uma verificação por corpo
+///
+/// @param world Mundo a ser atualizado
+void stepPhysics(World *world);
+
+/// Encontra os corpos de um mundo cujos limites interceptam uma área. Os limites considerados são os do fim do último stepPhysics (ou da adição do corpo, se for posterior): objetos movidos diretamente com setPosition e afins só são vistos após o próximo passo. As consultas não alocam memória, exceto ao remontar a grade após uma alteração do mundo, e não devem ser feitas por várias threads ao mesmo tempo
+///
+/// @param world Mundo a ser consultado
+/// @param area Área a ser testada
+/// @param mask Categorias de colisão (ver setCollisionLayers) aceitas. Corpos cuja categoria não intercepta a máscara são ignorados
+/// @param results Vetor onde os objetos encontrados são escritos, em nenhuma ordem específica
+/// @param max Total de posições de 'results'
+/// @return Total de objetos encontrados. Se for maior que 'max', apenas os 'max' primeiros foram escritos
+int queryRegion(World *world, Rectangle area, Uint32 mask, Object **results, int max);
+
+/// Encontra os corpos de um mundo que contêm um ponto, com o mesmo critério de isMouseOver. Os limites considerados são os mesmos de queryRegion
+///
+/// @param world Mundo a ser consultado
+/// @param pos Ponto a ser testado
+/// @param mask Categorias de colisão aceitas
+/// @param results Vetor onde os objetos encontrados são escritos, em nenhuma ordem específica
+/// @param max Total de posições de 'results'
+/// @return Total de objetos encontrados. Se for maior que 'max', apenas os 'max' primeiros foram escritos
+int queryPoint(World *world, Point pos, Uint32 mask, Object **results, int max);
+
+/// Encontra o primeiro corpo ou célula sólida da grade de colisão atingido por um segmento, percorrendo apenas as células da grade que o segmento atravessa. Corpos e células que contêm o ponto de partida são ignorados, para que um objeto possa lançar raios a partir de si mesmo. Para um raio, basta usar um ponto final distante
+///
+/// @param world Mundo a ser consultado
+/// @param from Ponto de partida
+/// @param to Ponto final
+/// @param mask Categorias de colisão aceitas. A grade de colisão é considerada se a categoria de seu objeto 'tile' for aceita
+/// @param hit Se não for nulo, recebe o ponto de impacto
+/// @return O objeto atingido (o objeto 'tile' da grade de colisão, para células sólidas), ou nulo se o segmento não atingir nada
+Object *castRay(World *world, Point from, Point to, Uint32 mask, Point *hit);
+
+/// Cria um instantâneo vazio, a ser preenchido com saveWorld
+///
+/// @return O instantâneo gerado
+WorldSnapshot *newWorldSnapshot();
+
+/// Grava o estado da simulação de um mundo num instantâneo. O bloco do instantâneo só é realocado se o mundo tiver crescido, de modo que gravar a cada frame não aloca memória. O instantâneo não guarda a grade de colisão, nem a massa, a velocidade máxima, as imagens e as categorias de colisão dos objetos
+///
+/// @param world Mundo a ser gravado
+/// @param snapshot Instantâneo onde o estado será gravado. O conteúdo anterior é descartado
+void saveWorld(World *world, WorldSnapshot *snapshot);
+
+/// Volta um mundo ao estado gravado num instantâneo. O mundo deve ter os mesmos corpos, na mesma ordem, de quando o instantâneo foi gravado. Os eventos de contato do último passo são descartados
+///
+/// @param world Mundo a ser restaurado
+/// @param snapshot Instantâneo gravado com saveWorld
+/// @return Verdadeiro se o estado foi restaurado, falso se os corpos do mundo não são os do instantâneo (nesse caso o mundo não é alterado)
+bool restoreWorld(World *world, WorldSnapshot *snapshot);
+
+/// Libera a memória usada por um instantâneo
+///
+/// @param snapshot Instantâneo a ser deletado
+void freeWorldSnapshot(WorldSnapshot *snapshot);
+
+/// Libera a memória usada por um mundo. As partículas e obstáculos não são deletados
+///
+/// @param world Mundo a ser deletado
+void freeWorld(World *world);
+
+#endif